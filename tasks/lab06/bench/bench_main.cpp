@@ -0,0 +1,489 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <filesystem>
+#include "Editor.h"
+#include "NPCFactory.h"
+#include "BattleVisitor.h"
+#include "Observer.h"
+#include "KillEventPipeline.h"
+#include "Simulation.h"
+#include "Journal.h"
+#include "TiledWorld.h"
+#include "BattleEngine.h"
+#include "BattleStats.h"
+
+// Случайный мир: count NPC в квадрате [0, spread]^2 (чем меньше spread, тем плотнее)
+static void fillWorld(Editor& editor, size_t count, double spread, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coord(0, spread);
+    std::uniform_int_distribution<int> type(0, 2);
+    for (size_t i = 0; i < count; ++i) {
+        editor.addNPC(NPCFactory::createNPC(static_cast<NPCType>(type(rng)),
+                                            "N" + std::to_string(i), coord(rng), coord(rng)));
+    }
+}
+
+static std::string benchFile(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Наблюдатель без вывода: стоимость самой рассылки
+class NullObserver : public BattleObserver {
+public:
+    size_t kills = 0;
+    void onKill(const KillEvent&) override { ++kills; }
+};
+
+// Боевой режим: число NPC, радиус, размер занятой области, число потоков
+static void BM_StartBattle(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    const double range = (double)state.range(1);
+    const double spread = (double)state.range(2);
+    BattleVisitor visitor;
+    visitor.addObserver(std::make_shared<NullObserver>());
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto editor = std::make_unique<Editor>();
+        editor->setThreadCount((size_t)state.range(3));
+        fillWorld(*editor, count, spread);
+        state.ResumeTiming();
+
+        editor->startBattle(range, visitor);
+
+        state.PauseTiming();
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_StartBattle)
+    ->ArgNames({"npcs", "range", "spread", "threads"})
+    ->Args({1000, 10, 500, 1})
+    ->Args({10000, 2, 500, 1})
+    ->Args({10000, 10, 500, 1})
+    ->Args({10000, 50, 500, 1})
+    ->Args({10000, 10, 100, 1})
+    ->Args({100000, 2, 500, 1})
+    ->Args({100000, 10, 500, 1})
+    ->Unit(benchmark::kMillisecond);
+
+// Тот же бой без наблюдателей: проход собирается с NullSink
+static void BM_StartBattleSilent(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    BattleVisitor visitor;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto editor = std::make_unique<Editor>();
+        editor->setThreadCount((size_t)state.range(2));
+        fillWorld(*editor, count, 100);
+        state.ResumeTiming();
+
+        editor->startBattle((double)state.range(1), visitor);
+
+        state.PauseTiming();
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_StartBattleSilent)
+    ->ArgNames({"npcs", "range", "threads"})
+    ->Args({100000, 2, 1})
+    ->Unit(benchmark::kMillisecond);
+
+// Последовательный и одновременный бой на одном мире без наблюдателей:
+// радиус, потоки, режим. В одновременном бою погибших больше, так как
+// убитый в этом бою NPC ещё сражается.
+static void BM_BattleMode(benchmark::State& state) {
+    const size_t count = 100000;
+    const BattleMode mode = state.range(2) ? BattleMode::Simultaneous : BattleMode::Sequential;
+    BattleVisitor visitor;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto editor = std::make_unique<Editor>();
+        editor->setThreadCount((size_t)state.range(1));
+        editor->setBattleMode(mode);
+        fillWorld(*editor, count, 500);
+        state.ResumeTiming();
+
+        editor->startBattle((double)state.range(0), visitor);
+
+        state.PauseTiming();
+        size_t dead = 0;
+        for (uint8_t alive : editor->getStore().aliveData()) {
+            dead += alive ? 0 : 1;
+        }
+        state.counters["dead"] = (double)dead;
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_BattleMode)
+    ->ArgNames({"range", "threads", "simultaneous"})
+    ->Args({2, 1, 0})
+    ->Args({2, 1, 1})
+    ->Args({10, 1, 0})
+    ->Args({10, 1, 1})
+    ->Args({10, 4, 1})
+    ->Unit(benchmark::kMillisecond);
+
+// Повторный бой после добавления небольшой партии NPC. Мир строится один раз,
+// первый повторный бой (он строит индекс хранилища) идёт до замера;
+// каждая итерация добавляет 100 драконов и замеряет только бой.
+static void BM_Rebattle(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    BattleVisitor visitor;
+    Editor editor;
+    fillWorld(editor, count, 500);
+    editor.startBattle(10, visitor);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coord(0, 500);
+    size_t added = 0;
+    auto addBatch = [&]() {
+        for (size_t i = 0; i < 100; ++i, ++added) {
+            editor.addNPC(NPCFactory::createNPC(NPCType::Dragon, "New" + std::to_string(added),
+                                                coord(rng), coord(rng)));
+        }
+    };
+    addBatch();
+    editor.startBattle(10, visitor);
+    for (auto _ : state) {
+        state.PauseTiming();
+        addBatch();
+        state.ResumeTiming();
+
+        editor.startBattle(10, visitor);
+    }
+}
+BENCHMARK(BM_Rebattle)->ArgName("npcs")->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Удаление погибших: каждый десятый NPC мёртв
+static void BM_RemoveDead(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto editor = std::make_unique<Editor>();
+        fillWorld(*editor, count, 500);
+        for (size_t i = 0; i < count; i += 10) {
+            editor->getNPC(i)->kill();
+        }
+        state.ResumeTiming();
+
+        editor->removeDeadNPCs();
+
+        state.PauseTiming();
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_RemoveDead)->ArgName("npcs")->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Массовое добавление готовых объектов
+static void BM_AddNPC(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    std::vector<std::shared_ptr<NPC>> npcs;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(0, 500);
+    for (size_t i = 0; i < count; ++i) {
+        npcs.push_back(NPCFactory::createNPC(NPCType::Bull, "N" + std::to_string(i),
+                                             coord(rng), coord(rng)));
+    }
+    for (auto _ : state) {
+        Editor editor;
+        for (const auto& npc : npcs) {
+            editor.addNPC(npc);
+        }
+        benchmark::DoNotOptimize(editor.getNPCCount());
+        // Объекты отвязываются от хранилища при уничтожении редактора
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_AddNPC)->ArgName("npcs")->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+// Массовое добавление по описаниям, без объектов NPC
+static void BM_AddNPCs(benchmark::State& state) {
+    const size_t count = (size_t)state.range(0);
+    std::vector<std::string> names;
+    std::vector<NPCSpec> specs;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coord(0, 500);
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("N" + std::to_string(i));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        specs.push_back({static_cast<NPCType>(i % 3), names[i], coord(rng), coord(rng)});
+    }
+    for (auto _ : state) {
+        auto editor = std::make_unique<Editor>();
+        benchmark::DoNotOptimize(editor->addNPCs(specs).addedCount);
+        state.PauseTiming();
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_AddNPCs)->ArgName("npcs")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// То же небольшими пакетами: место растёт вдвое, а не на каждом вызове
+static void BM_AddNPCsSmallBatches(benchmark::State& state) {
+    const size_t count = 100000;
+    const size_t batch = (size_t)state.range(0);
+    std::vector<std::string> names;
+    std::vector<NPCSpec> specs;
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("N" + std::to_string(i));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        specs.push_back({static_cast<NPCType>(i % 3), names[i], (double)(i % 500), (double)(i / 500 % 500)});
+    }
+    for (auto _ : state) {
+        auto editor = std::make_unique<Editor>();
+        for (size_t first = 0; first < count; first += batch) {
+            editor->addNPCs(specs.data() + first, std::min(batch, count - first));
+        }
+        state.PauseTiming();
+        editor.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)count);
+}
+BENCHMARK(BM_AddNPCsSmallBatches)->ArgName("batch")->Arg(10)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+// Сохранение и загрузка: текстовый формат и двоичный снимок
+static void BM_SaveToFile(benchmark::State& state) {
+    const bool binary = state.range(1) != 0;
+    Editor editor;
+    fillWorld(editor, (size_t)state.range(0), 500);
+    std::string filename = benchFile(binary ? "bench_world.bin" : "bench_world.txt");
+    for (auto _ : state) {
+        editor.saveToFile(filename);
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)std::filesystem::file_size(filename));
+    std::remove(filename.c_str());
+}
+BENCHMARK(BM_SaveToFile)
+    ->ArgNames({"npcs", "binary"})
+    ->Args({100000, 0})
+    ->Args({100000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFromFile(benchmark::State& state) {
+    const bool binary = state.range(1) != 0;
+    std::string filename = benchFile(binary ? "bench_load.bin" : "bench_load.txt");
+    {
+        Editor editor;
+        fillWorld(editor, (size_t)state.range(0), 500);
+        editor.saveToFile(filename);
+    }
+    Editor editor;
+    for (auto _ : state) {
+        editor.loadFromFile(filename);
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)std::filesystem::file_size(filename));
+    std::remove(filename.c_str());
+}
+BENCHMARK(BM_LoadFromFile)
+    ->ArgNames({"npcs", "binary"})
+    ->Args({100000, 0})
+    ->Args({100000, 1})
+    ->Unit(benchmark::kMillisecond);
+
+// Добавление одного NPC в большой мир с журналом (сравнить с BM_SaveToFile)
+static void BM_JournalAdd(benchmark::State& state) {
+    const std::string path = benchFile("bench_journal");
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".log").c_str());
+    Editor editor;
+    fillWorld(editor, (size_t)state.range(0), 500);
+    JournalOptions options;
+    options.groupCommit = (size_t)state.range(1);
+    editor.openJournal(path, options);
+    size_t next = 0;
+    for (auto _ : state) {
+        editor.addNPC(NPCFactory::createNPC(NPCType::Frog, "J" + std::to_string(next++), 1, 1));
+    }
+    editor.closeJournal();
+    state.SetItemsProcessed(state.iterations());
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".log").c_str());
+}
+BENCHMARK(BM_JournalAdd)
+    ->ArgNames({"npcs", "group"})
+    ->Args({100000, 1})
+    ->Args({100000, 64})
+    ->Unit(benchmark::kMicrosecond);
+
+// Разбор одной строки текстового формата с созданием объекта
+static void BM_LoadFromString(benchmark::State& state) {
+    const std::string line = "Dragon Smaug_the_Magnificent 123.456 78.9";
+    for (auto _ : state) {
+        auto npc = NPCFactory::loadFromString(line);
+        benchmark::DoNotOptimize(npc.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadFromString);
+
+// Рассылка событий: число наблюдателей, асинхронная доставка
+static void BM_ObserverDispatch(benchmark::State& state) {
+    const size_t observers = (size_t)state.range(0);
+    const bool async = state.range(1) != 0;
+    BattleVisitor visitor;
+    for (size_t k = 0; k < observers; ++k) {
+        visitor.addObserver(std::make_shared<NullObserver>());
+    }
+    if (async) {
+        visitor.enableAsync(4096, Backpressure::Block);
+    }
+    NameTable names;
+    KillEvent event{&names, names.intern("Killer"), names.intern("Victim"), false};
+    for (auto _ : state) {
+        visitor.notifyKill(event);
+    }
+    visitor.drain();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ObserverDispatch)
+    ->ArgNames({"observers", "async"})
+    ->Args({1, 0})
+    ->Args({4, 0})
+    ->Args({4, 1});
+
+// Запись событий в файл через буфер FileObserver
+static void BM_FileObserver(benchmark::State& state) {
+    std::string filename = benchFile("bench_events.log");
+    std::remove(filename.c_str());
+    NameTable names;
+    KillEvent event{&names, names.intern("Killer"), names.intern("Victim"), false};
+    {
+        FileObserver observer(filename);
+        for (auto _ : state) {
+            observer.onKill(event);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    std::remove(filename.c_str());
+}
+BENCHMARK(BM_FileObserver);
+
+// Один такт симуляции (движение + бои); счётчики — доли фаз
+static void BM_SimulationTick(benchmark::State& state) {
+    Editor editor;
+    fillWorld(editor, (size_t)state.range(0), 500);
+    SimulationConfig config;
+    config.range = 0.5;
+    Simulation simulation(editor, config);
+    BattleVisitor visitor;
+    simulation.run(1, visitor);
+    for (auto _ : state) {
+        simulation.run(1, visitor);
+    }
+    double move = 0, battle = 0;
+    for (const TickTiming& timing : simulation.getTimings()) {
+        move += (double)timing.moveTime.count();
+        battle += (double)timing.battleTime.count();
+    }
+    state.counters["move_share"] = move / (move + battle);
+    state.counters["alive"] = (double)simulation.getTimings().back().alive;
+}
+BENCHMARK(BM_SimulationTick)->ArgName("npcs")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Бой в мире из плиток 20x20 по 500 NPC; плитки читаются с диска по ходу боя.
+// При бюджете в 40 плиток в памяти около двух рядов
+static void BM_TiledBattle(benchmark::State& state) {
+    const size_t perTile = 500;
+    TiledWorldConfig config;
+    config.directory = benchFile("bench_tiles_source");
+    config.tilesX = 20;
+    config.tilesY = 20;
+    std::filesystem::remove_all(config.directory);
+    {
+        TiledWorld world(config);
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> offset(0, config.tileSize);
+        std::uniform_int_distribution<int> type(0, 2);
+        for (size_t i = 0; i < 400 * perTile; ++i) {
+            size_t tile = i / perTile;
+            world.addNPC(static_cast<NPCType>(type(rng)), "N" + std::to_string(i),
+                         (double)(tile % 20) * config.tileSize + offset(rng),
+                         (double)(tile / 20) * config.tileSize + offset(rng));
+        }
+    }
+    const std::string source = config.directory;
+    config.directory = benchFile("bench_tiles");
+    config.memoryBudget = (size_t)state.range(0) * perTile * TiledWorld::BYTES_PER_NPC;
+    BattleVisitor visitor;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(config.directory);
+        std::filesystem::copy(source, config.directory);
+        auto world = std::make_unique<TiledWorld>(config);
+        state.ResumeTiming();
+
+        world->startBattle(10, visitor);
+
+        state.PauseTiming();
+        state.counters["loads"] = (double)world->getLoadCount();
+        world.reset();
+        state.ResumeTiming();
+    }
+    std::filesystem::remove_all(config.directory);
+    std::filesystem::remove_all(source);
+    state.SetItemsProcessed(state.iterations() * 400 * (int64_t)perTile);
+}
+BENCHMARK(BM_TiledBattle)->ArgName("budget_tiles")->Arg(40)->Arg(400)->Unit(benchmark::kMillisecond);
+
+// Пространственные запросы к миру из 100k NPC (индекс уже построен)
+static void BM_QueryRadius(benchmark::State& state) {
+    Editor editor;
+    fillWorld(editor, 100000, 500);
+    const double radius = (double)state.range(0);
+    std::vector<size_t> out(100000);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(0, 500);
+    size_t found = 0;
+    for (auto _ : state) {
+        found += editor.queryRadius(coord(rng), coord(rng), radius, out.data(), out.size(),
+                                    NPCFilter::alive());
+    }
+    state.counters["found"] = benchmark::Counter((double)found, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryRadius)->ArgName("radius")->Arg(5)->Arg(20);
+
+static void BM_NearestK(benchmark::State& state) {
+    Editor editor;
+    fillWorld(editor, 100000, 500);
+    const size_t k = (size_t)state.range(0);
+    std::vector<size_t> out(k);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(0, 500);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(editor.nearestK(coord(rng), coord(rng), k, out.data()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NearestK)->ArgName("k")->Arg(1)->Arg(16);
+
+// Как BENCHMARK_MAIN, но с типом сборки проекта в контексте JSON:
+// library_build_type там относится к самой библиотеке Google Benchmark
+int main(int argc, char** argv) {
+#ifdef NDEBUG
+    benchmark::AddCustomContext("project_build_type", "release");
+#else
+    benchmark::AddCustomContext("project_build_type", "debug");
+#endif
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Сравнение результатов bench (JSON Google Benchmark) с сохранённой базой.
+
+    compare.py baseline.json results.json [--threshold 10]
+
+Для каждого бенчмарка печатается изменение времени в процентах.
+Код возврата 1, если хотя бы один стал медленнее больше чем на порог.
+"""
+import argparse
+import json
+import sys
+
+UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    # Сравнивать имеет смысл только сборки Release
+    build = data.get("context", {}).get("project_build_type", "неизвестна")
+    if build != "release":
+        print(f"{path}: сборка проекта {build}, а не release", file=sys.stderr)
+    result = {}
+    for bench in data.get("benchmarks", []):
+        # При --benchmark_repetitions сравниваются медианы
+        if bench.get("run_type") == "aggregate" and bench.get("aggregate_name") != "median":
+            continue
+        name = bench.get("run_name", bench["name"])
+        unit = bench.get("time_unit", "ns")
+        result[name] = (bench["real_time"] * UNITS[unit], unit)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="допустимое замедление, %% (по умолчанию 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    results = load(args.results)
+
+    regressions = 0
+    width = max((len(name) for name in results), default=10)
+    for name, (time, unit) in results.items():
+        if name not in baseline:
+            print(f"{name:<{width}}  нет в базе")
+            continue
+        base = baseline[name][0]
+        change = (time - base) / base * 100.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  ЗАМЕДЛЕНИЕ"
+            regressions += 1
+        scale = UNITS[unit]
+        print(f"{name:<{width}}  {base / scale:10.3f} -> {time / scale:10.3f} {unit}  {change:+7.1f}%{mark}")
+
+    for name in baseline:
+        if name not in results:
+            print(f"{name:<{width}}  нет в результатах")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
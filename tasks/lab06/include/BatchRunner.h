@@ -0,0 +1,41 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Один сценарий пакетного режима: загрузка -> бой -> сохранение
+struct BatchScenario {
+    std::string load;    // Файл мира (пусто — пустой мир)
+    bool battle = false;
+    double range = 0;    // Радиус боя, если battle
+    std::string save;    // Файл результата (пусто — не сохранять)
+};
+
+struct BatchOptions {
+    std::vector<BatchScenario> scenarios;
+    bool quiet = false;  // Без вывода событий боя и итогов по сценариям
+    bool stats = false;  // Печатать статистику боя
+    size_t jobs = 1;     // Сценарии, обрабатываемые одновременно
+};
+
+// Неинтерактивный режим редактора:
+//   editor --load a.txt --battle 50 --save out.bin --quiet
+//   editor --manifest scenarios.txt --jobs 8 --quiet
+class BatchRunner {
+public:
+    // Разбор аргументов командной строки; при ошибке — false и текст в error
+    static bool parseArguments(int argc, const char* const* argv, BatchOptions& options,
+                               std::string& error);
+
+    // Чтение манифеста: строка "LOAD [RANGE|-] [SAVE]", "#" — комментарий
+    static bool loadManifest(const std::string& filename, std::vector<BatchScenario>& scenarios,
+                             std::string& error);
+
+    // Выполнить сценарии; события боя и итоги каждого сценария копятся
+    // отдельно и печатаются в out в порядке сценариев (отчёт неудачного — в err).
+    // Возвращает число неудачных сценариев.
+    static size_t run(const BatchOptions& options, std::ostream& out, std::ostream& err);
+
+    static void printUsage(std::ostream& out);
+};
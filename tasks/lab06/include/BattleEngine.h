@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include "NPCStore.h"
+#include "SpatialGrid.h"
+#include "BattleSink.h"
+
+class ThreadPool;
+struct BattleStats;
+
+// Разрешение боёв над хранилищем NPC.
+// Результат всегда совпадает с полным перебором пар (i, j), i < j, по порядку:
+// пара сражается, если оба NPC живы к моменту её рассмотрения
+// (кроме resolveSimultaneous, где важна жизнь к началу боя).
+// Если передан stats, в него добавляются счётчики и время фаз прохода.
+// Каждый проход есть в двух вариантах: с BattleVisitor (события уходят его
+// наблюдателям) и с NullSink (те же убийства, события не строятся вовсе).
+class BattleEngine {
+public:
+    // Общий цикл последовательного боя. Для каждого живого нападающего i
+    // findTargets(i, targets) заполняет противников j > i в пределах дальности
+    // по возрастанию j; пары сражаются, пока i жив, и onFight(i, j, outcome)
+    // вызывается для каждого состоявшегося боя. Так устроены resolve
+    // и resolveIndexed.
+    template <typename FindTargets, typename OnFight>
+    static void fightInOrder(NPCStore& store, FindTargets&& findTargets, OnFight&& onFight) {
+        const std::vector<NPCType>& types = store.typeData();
+        std::vector<size_t> targets;
+        for (size_t i = 0; i < store.size(); ++i) {
+            // Тот, кто не может напасть (жаба), пропускается целиком
+            if (!canAttack(types[i]) || !store.isAlive(i)) {
+                continue;
+            }
+            findTargets(i, targets);
+            for (size_t j : targets) {
+                if (!store.isAlive(i)) {
+                    break;
+                }
+                BattleOutcome outcome = battleOutcome(types[i], types[j]);
+                if (store.applyOutcome(i, j, outcome)) {
+                    onFight(i, j, outcome);
+                }
+            }
+        }
+    }
+
+    // Однопоточный проход
+    static void resolve(NPCStore& store, const MapBounds& bounds, double range,
+                        BattleVisitor& visitor, BattleStats* stats = nullptr);
+    static void resolve(NPCStore& store, const MapBounds& bounds, double range,
+                        NullSink sink, BattleStats* stats = nullptr);
+
+    // Однопоточный проход по пространственному индексу хранилища
+    // (store.spatialIndex) вместо сетки, которую resolve строит на каждый бой.
+    // Для мира, где NPC двигаются между боями (такты Simulation): индекс
+    // обновляется при перемещении. Результат совпадает с resolve.
+    static void resolveIndexed(NPCStore& store, const MapBounds& bounds, double range,
+                               BattleVisitor& visitor, BattleStats* stats = nullptr);
+    static void resolveIndexed(NPCStore& store, const MapBounds& bounds, double range,
+                               NullSink sink, BattleStats* stats = nullptr);
+
+    // Повторный бой: рассматриваются только пары (i, j) с j >= firstDirty.
+    // Подходит, когда NPC до firstDirty уже прошли бой с радиусом не меньше range:
+    // пары выживших из них сражаться не могут, и результат совпадает с resolve.
+    // Пары ищутся от новых NPC по store.spatialIndex: индекс строится при первом
+    // повторном бое (O(N)) и дальше обновляется хранилищем, так что следующие
+    // бои стоят пропорционально числу новых NPC и их соседей.
+    static void resolveDirty(NPCStore& store, const MapBounds& bounds, double range,
+                             size_t firstDirty, BattleVisitor& visitor,
+                             BattleStats* stats = nullptr);
+    static void resolveDirty(NPCStore& store, const MapBounds& bounds, double range,
+                             size_t firstDirty, NullSink sink,
+                             BattleStats* stats = nullptr);
+
+    // Одновременный бой: сражаются все пары в пределах дальности, живые к началу
+    // боя, независимо от исходов других пар. Убитые копятся отдельно и снимаются
+    // в конце, поэтому порядок пар на результат не влияет и поиск делится между
+    // потоками pool (nullptr — в одном потоке). События идут в порядке (i, j).
+    static void resolveSimultaneous(NPCStore& store, const MapBounds& bounds, double range,
+                                    BattleVisitor& visitor, ThreadPool* pool = nullptr,
+                                    BattleStats* stats = nullptr);
+    static void resolveSimultaneous(NPCStore& store, const MapBounds& bounds, double range,
+                                    NullSink sink, ThreadPool* pool = nullptr,
+                                    BattleStats* stats = nullptr);
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "NPC.h"
+
+// Исход встречи нападающего (первый NPC пары) с защищающимся
+enum class BattleOutcome : uint8_t {
+    None,           // Бой не происходит
+    AttackerKills,  // Нападающий убивает защищающегося
+    MutualKill      // Оба погибают
+};
+
+// Таблица исходов: строка — тип нападающего, столбец — тип защищающегося
+constexpr BattleOutcome BATTLE_OUTCOMES[NPC_TYPE_COUNT][NPC_TYPE_COUNT] = {
+    //  Dragon                      Bull                          Frog
+    { BattleOutcome::MutualKill, BattleOutcome::AttackerKills, BattleOutcome::None },          // Dragon
+    { BattleOutcome::None,       BattleOutcome::MutualKill,    BattleOutcome::AttackerKills }, // Bull
+    { BattleOutcome::None,       BattleOutcome::None,          BattleOutcome::None },          // Frog
+};
+
+constexpr BattleOutcome battleOutcome(NPCType attacker, NPCType defender) {
+    return BATTLE_OUTCOMES[static_cast<size_t>(attacker)][static_cast<size_t>(defender)];
+}
+
+// Может ли NPC этого типа вообще на кого-то напасть
+constexpr bool canAttack(NPCType attacker) {
+    for (size_t d = 0; d < NPC_TYPE_COUNT; ++d) {
+        if (BATTLE_OUTCOMES[static_cast<size_t>(attacker)][d] != BattleOutcome::None) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static_assert(!canAttack(NPCType::Frog), "Жабы спасаются как могут");
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include "BattleRules.h"
+#include "BattleVisitor.h"
+
+class NPCStore;
+
+// Политики приёма событий боя для BattleEngine и Simulation (выбираются
+// при компиляции). Исход боя к хранилищу применяет сам проход, приёмник
+// получает только уже состоявшийся бой. ENABLED = false убирает построение
+// событий и всё, что нужно только для них, из прохода целиком.
+
+// Без наблюдателей: события не строятся
+struct NullSink {
+    static constexpr bool ENABLED = false;
+    void onFight(const NPCStore&, size_t, size_t, BattleOutcome) {}
+};
+
+// Динамическая политика: события уходят наблюдателям BattleVisitor (addObserver)
+class VisitorSink {
+private:
+    BattleVisitor& visitor;
+
+public:
+    static constexpr bool ENABLED = true;
+
+    explicit VisitorSink(BattleVisitor& visitor) : visitor(visitor) {}
+
+    void onFight(const NPCStore& store, size_t attacker, size_t defender, BattleOutcome outcome) {
+        visitor.notifyFight(store, attacker, defender, outcome);
+    }
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include "NPC.h"
+
+// Статистика одного боя. Собирается, только если передана в startBattle:
+// без неё боевой проход компилируется без счётчиков и замеров времени.
+struct BattleStats {
+    uint64_t rangeChecks = 0;     // Проверено расстояний (точки из соседних клеток)
+    uint64_t candidatePairs = 0;  // Пар в пределах дальности с возможным исходом боя
+    uint64_t fights = 0;          // Пар, дошедших до боя (оба участника живы)
+    // Погибшие по парам типов: kills[тип убийцы][тип жертвы]
+    uint64_t kills[NPC_TYPE_COUNT][NPC_TYPE_COUNT] = {};
+
+    // Время по фазам
+    std::chrono::nanoseconds gridTime{0};      // Построение сетки
+    std::chrono::nanoseconds searchTime{0};    // Поиск пар в пределах дальности
+    std::chrono::nanoseconds fightTime{0};     // Бои и рассылка событий
+    std::chrono::nanoseconds deliveryTime{0};  // Доставка событий и завершение боя
+
+    uint64_t totalKills() const;
+
+    // Отчёт для консоли
+    void print(std::ostream& out) const;
+};
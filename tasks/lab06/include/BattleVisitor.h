@@ -1,34 +1,85 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <string>
+#include <string_view>
+#include "BattleRules.h"
+#include "NameTable.h"
 
 class NPC;
-class Dragon;
-class Bull;
-class Frog;
 class BattleObserver;
+class NPCStore;
+class KillEventPipeline;
+struct KillEvent;
+enum class Backpressure;
 
 class BattleVisitor {
 private:
     std::vector<std::shared_ptr<BattleObserver>> observers;  // Наблюдатели событий
+    std::unique_ptr<KillEventPipeline> pipeline;              // Асинхронная доставка (если включена)
+    NameTable localNames;  // Имена NPC, сражавшихся вне хранилища редактора (до конца боя)
+    
+    // Синхронная рассылка события всем наблюдателям
+    void dispatchKill(const KillEvent& event);
+    
+    // Номер имени в localNames; новое имя добавляется, не дожидаясь очереди
+    NameId localName(std::string_view name);
 
 public:
+    BattleVisitor();
+    ~BattleVisitor();
+    
+    // Включить асинхронную доставку событий: наблюдатели вызываются
+    // из отдельного потока через очередь на capacity событий
+    void enableAsync(size_t capacity, Backpressure policy);
+    
+    // Вернуться к синхронной доставке (после доставки очереди)
+    void disableAsync();
+    
+    bool isAsync() const { return pipeline != nullptr; }
+    
+    // Дождаться доставки всех событий из очереди
+    void drain();
+    
+    // Сколько событий отброшено из-за заполненной очереди
+    size_t droppedEvents() const;
+    
     // Добавление наблюдателя
     void addObserver(std::shared_ptr<BattleObserver> observer);
     
-    // Уведомление о событии убийства
-    void notifyKill(const std::string& killer, const std::string& victim);
-    
-    // Логика боев для каждой пары типов
-    void visit(Dragon& dragon, Bull& bull);
-    void visit(Bull& bull, Frog& frog);
-    void visit(Dragon& dragon, Frog& frog);
-    void visit(Bull& bull, Dragon& dragon);
-    void visit(Frog& frog, Bull& bull);
-    void visit(Frog& frog, Dragon& dragon);
-    
-    // Бои одинаковых типов - оба погибают
-    void visit(Dragon& d1, Dragon& d2);
-    void visit(Bull& b1, Bull& b2);
-    void visit(Frog& f1, Frog& f2);
+    // Есть ли наблюдатели (без них боевой проход не строит событий)
+    bool hasObservers() const { return !observers.empty(); }
+    
+    // Уведомление о событии убийства. В асинхронном режиме имена события
+    // не должны освобождаться до drain() (добавлять новые в таблицу можно).
+    void notifyKill(const KillEvent& event);
+    
+    // Уведомление о завершении боя. Скопированные имена после него не нужны
+    // и освобождаются.
+    void notifyBattleEnd();
+    
+    // Применить исход боя к паре и уведомить наблюдателей
+    void fight(NPC& attacker, NPC& defender, BattleOutcome outcome);
+    
+    // То же, с исходом из таблицы по тегам типов
+    void fight(NPC& attacker, NPC& defender);
+    
+    // То же для NPC, лежащих в хранилище редактора (по номерам слотов)
+    void fight(NPCStore& store, size_t attacker, size_t defender, BattleOutcome outcome);
+    
+    // Уведомить о бое, исход которого уже применён к хранилищу
+    void notifyFight(const NPCStore& store, size_t attacker, size_t defender, BattleOutcome outcome);
+
+    // То же для пары из разных хранилищ: имена копируются в localNames до
+    // конца боя, так что событие не зависит от времени жизни хранилищ
+    void notifyFight(const NPCStore& attackerStore, size_t attacker,
+                     const NPCStore& defenderStore, size_t defender, BattleOutcome outcome);
+    
+    // Бой пары конкретных типов (вызывается из NPC::accept). Исходы для всех
+    // пар заданы таблицей BATTLE_OUTCOMES; особый бой пары типов задаётся
+    // перегрузкой visit для этих типов.
+    template <typename Attacker, typename Defender>
+    void visit(Attacker& attacker, Defender& defender) {
+        fight(attacker, defender);
+    }
 };
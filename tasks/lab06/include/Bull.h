@@ -3,7 +3,9 @@
 
 class Bull : public NPC {
 public:
-    Bull(const std::string& name, double x, double y);
-    void accept(BattleVisitor& visitor, NPC& other) override;
-    std::string getType() const override { return "Bull"; }
+    static constexpr NPCType TAG = NPCType::Bull;
+    static constexpr std::string_view NAME = "Bull";
+
+    Bull(std::string_view name, double x, double y);
+    std::string getType() const override { return std::string(NAME); }
 };
@@ -3,7 +3,9 @@
 
 class Dragon : public NPC {
 public:
-    Dragon(const std::string& name, double x, double y);
-    void accept(BattleVisitor& visitor, NPC& other) override;
-    std::string getType() const override { return "Dragon"; }
+    static constexpr NPCType TAG = NPCType::Dragon;
+    static constexpr std::string_view NAME = "Dragon";
+
+    Dragon(std::string_view name, double x, double y);
+    std::string getType() const override { return std::string(NAME); }
 };
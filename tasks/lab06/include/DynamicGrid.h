@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SpatialGrid.h"
+#include "RangeKernel.h"
+
+// Буферы DynamicGrid::forEachWithin: кандидаты из клеток и маска дальности
+// (память переиспользуется между вызовами)
+struct RangeScratch {
+    std::vector<size_t> indices;
+    std::vector<double> xs, ys;
+    std::vector<uint64_t> mask;
+};
+
+// Сетка для движущихся NPC: в отличие от SpatialGrid не перестраивается,
+// а обновляется по одному NPC. Клетка хранит двусвязный список номеров NPC
+// в массивах next/prev (без выделений памяти при перемещении).
+// У клетки два списка: основной и отложенных NPC (park — например, погибших).
+// Отложенные видны в обходах клеток, но не в forEachWithin.
+class DynamicGrid {
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    double minX, minY;
+    double cellSize;
+    size_t width, height;
+
+    std::vector<uint32_t> head;        // Первый NPC клетки
+    std::vector<uint32_t> parkedHead;  // Первый отложенный NPC клетки
+    std::vector<uint32_t> next, prev;
+    std::vector<uint32_t> cellOf;  // Клетка NPC (NONE — не в сетке)
+    std::vector<uint8_t> parked;   // 1 — NPC в списке отложенных
+
+    size_t cellCoord(double value, double origin, size_t cells) const;
+    size_t cellIndex(double x, double y) const {
+        return cellCoord(y, minY, height) * width + cellCoord(x, minX, width);
+    }
+    void link(uint32_t i, size_t cell, bool toParked);
+    void unlink(uint32_t i);
+
+    template <typename Func>
+    static void forEachInList(const std::vector<uint32_t>& next, uint32_t first, Func& func) {
+        for (uint32_t k = first; k != NONE; k = next[k]) {
+            func((size_t)k);
+        }
+    }
+
+public:
+    // Сетка не перестраивается, поэтому может быть мельче SpatialGrid:
+    // при плотном мире в соседних клетках меньше лишних кандидатов
+    static constexpr size_t MAX_CELLS_PER_AXIS = 2048;
+
+    // Клетка не меньше радиуса боя
+    DynamicGrid(const MapBounds& bounds, double range);
+
+    // Очистить сетку и подготовить место под count NPC
+    void reset(size_t count);
+
+    void insert(size_t i, double x, double y);
+    void remove(size_t i);
+    // Перенести NPC в список отложенных его клетки (insert возвращает в основной)
+    void park(size_t i);
+
+    // Новое положение NPC; списки меняются, только если NPC сменил клетку
+    // (отложенный остаётся отложенным). NPC, которого нет в сетке, не добавляется.
+    void move(size_t i, double x, double y);
+
+    bool contains(size_t i) const { return i < cellOf.size() && cellOf[i] != NONE; }
+
+    size_t getWidth() const { return width; }
+    size_t getHeight() const { return height; }
+    double getCellSize() const { return cellSize; }
+
+    // Столбец и строка клетки точки (за пределами сетки — крайние)
+    size_t column(double x) const { return cellCoord(x, minX, width); }
+    size_t row(double y) const { return cellCoord(y, minY, height); }
+
+    // Обход NPC из клеток [col0, col1] x [row0, row1] (границы включительно)
+    template <typename Func>
+    void forEachInCells(size_t col0, size_t row0, size_t col1, size_t row1, Func&& func) const {
+        for (size_t r = row0; r <= row1; ++r) {
+            for (size_t c = col0; c <= col1; ++c) {
+                forEachInList(next, head[r * width + c], func);
+                forEachInList(next, parkedHead[r * width + c], func);
+            }
+        }
+    }
+
+    // Обход NPC из клетки точки (x, y) и восьми соседних
+    template <typename Func>
+    void forEachNeighbour(double x, double y, Func&& func) const {
+        size_t cx = column(x);
+        size_t cy = row(y);
+        forEachInCells(cx > 0 ? cx - 1 : 0, cy > 0 ? cy - 1 : 0,
+                       cx + 1 < width ? cx + 1 : cx, cy + 1 < height ? cy + 1 : cy, func);
+    }
+
+    // Обход NPC из клеток, задетых прямоугольником
+    template <typename Func>
+    void forEachInRect(double minX, double minY, double maxX, double maxY, Func&& func) const {
+        if (minX <= maxX && minY <= maxY) {
+            forEachInCells(column(minX), row(minY), column(maxX), row(maxY), func);
+        }
+    }
+
+    // Обход NPC не дальше range от точки (x, y); xs, ys — координаты NPC по номерам.
+    // Кандидаты из задетых клеток собираются подряд и проверяются пакетом
+    // (rangeMask), поэтому размер клетки может быть любым. Отложенные NPC
+    // не обходятся. Возвращает число кандидатов.
+    template <typename Func>
+    size_t forEachWithin(const double* xs, const double* ys, double x, double y, double range,
+                         RangeScratch& scratch, Func&& func) const {
+        scratch.indices.clear();
+        scratch.xs.clear();
+        scratch.ys.clear();
+        auto gather = [&](size_t k) {
+            scratch.indices.push_back(k);
+            scratch.xs.push_back(xs[k]);
+            scratch.ys.push_back(ys[k]);
+        };
+        if (x - range <= x + range && y - range <= y + range) {
+            const size_t col0 = column(x - range), col1 = column(x + range);
+            const size_t row0 = row(y - range), row1 = row(y + range);
+            for (size_t r = row0; r <= row1; ++r) {
+                for (size_t c = col0; c <= col1; ++c) {
+                    forEachInList(next, head[r * width + c], gather);
+                }
+            }
+        }
+        const size_t count = scratch.indices.size();
+        scratch.mask.resize(rangeMaskWords(count));
+        rangeMask(x, y, scratch.xs.data(), scratch.ys.data(), count, range * range, scratch.mask.data());
+        for (size_t w = 0; w < scratch.mask.size(); ++w) {
+            for (uint64_t bits = scratch.mask[w]; bits != 0; bits &= bits - 1) {
+                func(scratch.indices[w * 64 + __builtin_ctzll(bits)]);
+            }
+        }
+        return count;
+    }
+
+    // Обход NPC из клеток на расстоянии ring клеток (по Чебышёву) от клетки (col, row).
+    // Кольца 0, 1, 2... обходят сетку от центра наружу; false — кольцо целиком вне сетки.
+    template <typename Func>
+    bool forEachInRing(size_t col, size_t row, size_t ring, Func&& func) const {
+        const size_t c0 = col >= ring ? col - ring : 0;
+        const size_t r0 = row >= ring ? row - ring : 0;
+        const size_t c1 = std::min(col + ring, width - 1);
+        const size_t r1 = std::min(row + ring, height - 1);
+        bool any = false;
+        // Верхняя и нижняя строки кольца целиком, затем боковые столбцы между ними
+        if (row >= ring) {
+            forEachInCells(c0, row - ring, c1, row - ring, func);
+            any = true;
+        }
+        if (ring > 0 && row + ring < height) {
+            forEachInCells(c0, row + ring, c1, row + ring, func);
+            any = true;
+        }
+        const size_t inner0 = row >= ring ? row - ring + 1 : r0;
+        const size_t inner1 = row + ring < height ? row + ring - 1 : r1;
+        if (ring > 0 && inner0 <= inner1) {
+            if (col >= ring) {
+                forEachInCells(col - ring, inner0, col - ring, inner1, func);
+                any = true;
+            }
+            if (col + ring < width) {
+                forEachInCells(col + ring, inner0, col + ring, inner1, func);
+                any = true;
+            }
+        }
+        return any;
+    }
+};
@@ -2,41 +2,269 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
 #include "NPC.h"
+#include "NPCStore.h"
+#include "NPCPool.h"
 #include "BattleVisitor.h"
+#include "SpatialGrid.h"
+
+class ThreadPool;
+class Journal;
+struct BattleStats;
+struct JournalOptions;
+
+// Формат файла сохранения
+enum class SaveFormat {
+    Auto,    // Двоичный для расширения ".bin", иначе текстовый
+    Text,    // Строки "Type Name X Y"
+    Binary   // Двоичный снимок (WorldSnapshot)
+};
+
+// Порядок разрешения боёв
+enum class BattleMode {
+    Sequential,   // Пары по порядку (i, j); погибший в бою пары дальше не сражается
+    Simultaneous  // Все пары, живые к началу боя, сражаются; убитые снимаются в конце
+};
+
+// Ошибка в строке файла при загрузке
+struct LoadError {
+    size_t line;          // Номер строки (в снимке — записи), начиная с 1
+    std::string message;
+};
+
+// Описание NPC для массового добавления (имя должно жить до конца вызова)
+struct NPCSpec {
+    NPCType type;
+    std::string_view name;
+    double x, y;
+};
+
+// Итог массового добавления: бит k слова added[k / 64] равен 1,
+// если NPC k из пакета добавлен
+struct BulkAddResult {
+    std::vector<uint64_t> added;
+    size_t addedCount = 0;
+
+    bool isAdded(size_t k) const { return ((added[k / 64] >> (k % 64)) & 1u) != 0; }
+};
+
+// Отбор NPC в пространственных запросах (по умолчанию подходят все)
+struct NPCFilter {
+    static constexpr uint32_t ALL_TYPES = (1u << NPC_TYPE_COUNT) - 1;
+
+    uint32_t typeMask = ALL_TYPES;  // Бит 1 << тег для каждого подходящего типа
+    bool aliveOnly = false;         // Только живые
+
+    static NPCFilter alive() {
+        NPCFilter filter;
+        filter.aliveOnly = true;
+        return filter;
+    }
+
+    static NPCFilter ofType(NPCType type, bool aliveOnly = false) {
+        NPCFilter filter;
+        filter.typeMask = 1u << static_cast<uint32_t>(type);
+        filter.aliveOnly = aliveOnly;
+        return filter;
+    }
+
+    bool accepts(const NPCStore& store, size_t i) const {
+        return ((typeMask >> static_cast<uint32_t>(store.type(i))) & 1u) != 0 &&
+               (!aliveOnly || store.isAlive(i));
+    }
+};
 
 class Editor {
 private:
-    std::vector<std::shared_ptr<NPC>> npcs;  // Список всех NPC
+    NPCStore store;  // Все NPC в виде параллельных массивов
+    // Арена для объектов NPC, выдаваемых getNPC и createNPC
+    mutable NPCPool pool;
+    // Потоки боевого режима (нет — однопоточный проход)
+    std::unique_ptr<ThreadPool> threads;
+    
+    // Состояние для повторных боёв. Новые NPC добавляются в конец, а удаление
+    // переставляет записи, не смешивая проверенных с новыми, поэтому NPC,
+    // прошедшие бой, всегда идут первыми: слоты [0, checkedCount) уже
+    // сражались с радиусом checkedRange.
+    size_t checkedCount = 0;
+    double checkedRange = 0;
+    
+    BattleMode battleMode = BattleMode::Sequential;
+    
+    // Журнал изменений (нет — изменения сохраняются только через saveToFile)
+    std::unique_ptr<Journal> journal;
+    // Индексы NPC, убитых после последней записи в журнал
+    std::vector<uint32_t> killed;
+    
+    // Проход по парам NPC в пределах дальности
+    void resolveBattle(double range, BattleVisitor& visitor, BattleStats* stats);
+    
+    // Записать накопленные убийства в журнал и сжать его, если пора
+    void journalKills();
+    
+    // Точка на карте (NaN — нет)
+    static bool isOnMap(double x, double y) {
+        return x >= 0 && x <= MAP_SIZE && y >= 0 && y <= MAP_SIZE;
+    }
+    
+    // Индекс пространственных запросов (строится хранилищем при первом запросе)
+    const DynamicGrid& queryIndex() const {
+        return store.spatialIndex({0, 0, MAP_SIZE, MAP_SIZE}, QUERY_CELL_SIZE);
+    }
     
 public:
-    // Добавить NPC на карту
-    bool addNPC(std::shared_ptr<NPC> npc);
+    // Размер квадратной карты (метры)
+    static constexpr double MAP_SIZE = 500.0;
+    // Сторона клетки индекса запросов
+    static constexpr double QUERY_CELL_SIZE = MAP_SIZE / 256;
+
+    Editor();
+    ~Editor();
+
+    // Добавить NPC на карту; при успехе в handle (если передан) пишется ссылка на него
+    bool addNPC(std::shared_ptr<NPC> npc, NPCHandle* handle = nullptr);
     
-    // Проверка уникальности имени
-    bool isNameUnique(const std::string& name) const;
+    // Добавить пакет NPC за один проход: место резервируется сразу, координаты
+    // и имена проверяются по тем же правилам, что в addNPC (из повторов имени
+    // внутри пакета добавляется первый). Объекты NPC не создаются.
+    BulkAddResult addNPCs(const NPCSpec* specs, size_t count);
+    BulkAddResult addNPCs(const std::vector<NPCSpec>& specs) { return addNPCs(specs.data(), specs.size()); }
+    
+    // Проверка уникальности имени (по хеш-индексу хранилища)
+    bool isNameUnique(std::string_view name) const;
     
     // Сохранение в файл
-    bool saveToFile(const std::string& filename) const;
+    bool saveToFile(const std::string& filename, SaveFormat format = SaveFormat::Auto) const;
+    
+    // Загрузка из файла; формат определяется по сигнатуре в начале файла.
+    // Строки с уже встречавшимися именами пропускаются. Некорректные строки
+    // пропускаются и, если передан errors, попадают в него. Повреждённый
+    // двоичный снимок не загружается вовсе и даёт ошибку со строкой 0,
+    // а снимок с пустым или повторным именем — с номером этой записи.
+    bool loadFromFile(const std::string& filename, std::vector<LoadError>* errors = nullptr);
+    
+    // Включить журнал изменений PATH.snapshot + PATH.log. Если файлы уже есть,
+    // мир восстанавливается из них (снимок и хвост журнала), иначе текущий мир
+    // становится первым снимком. Дальше добавления, убийства, удаление
+    // погибших и очистка пишутся в журнал группами.
+    bool openJournal(const std::string& path, const JournalOptions& options,
+                     std::string* error = nullptr);
+    bool openJournal(const std::string& path, std::string* error = nullptr);
     
-    // Загрузка из файла
-    bool loadFromFile(const std::string& filename);
+    // Записать накопленную группу на диск
+    bool syncJournal();
+    
+    // Сжать журнал в новый снимок (например, после симуляции: перемещения
+    // в журнал не пишутся)
+    bool compactJournal();
+    
+    // Закрыть журнал, записав накопленное
+    void closeJournal();
+    
+    bool hasJournal() const { return journal != nullptr; }
     
     // Печать всех NPC
     void printAll() const;
     
-    // Запуск боевого режима
-    void startBattle(double range, BattleVisitor& visitor);
+    // Запуск боевого режима. Повторный бой с тем же или меньшим радиусом
+    // рассматривает только пары с NPC, добавленными после прошлого боя.
+    // Если передан stats, он заполняется статистикой этого боя.
+    void startBattle(double range, BattleVisitor& visitor, BattleStats* stats = nullptr);
+    
+    // Переместить NPC (координата должна быть на карте). Индекс запросов
+    // обновляется, а следующий startBattle идёт полным проходом.
+    void moveNPC(size_t index, double x, double y) {
+        store.setPosition(index, x, y);
+        checkedCount = 0;
+    }
+    
+    // Бой одного такта симуляции: пары ищутся по индексу запросов, который
+    // moveNPC держит в актуальном состоянии. События остаются в очереди
+    // visitor до drain; убийства попадут в журнал при следующей записи.
+    void resolveMoving(double range, BattleVisitor& visitor, BattleStats* stats = nullptr);
+    
+    // Число NPC, добавленных или загруженных после прошлого боя
+    size_t getDirtyCount() const { return store.size() - checkedCount; }
     
-    // Удаление мертвых NPC
+    // Порядок разрешения боёв (по умолчанию последовательный)
+    void setBattleMode(BattleMode mode) { battleMode = mode; }
+    BattleMode getBattleMode() const { return battleMode; }
+    
+    // Число потоков одновременного боя (1 — однопоточный проход).
+    // Результат и порядок событий от числа потоков не зависят.
+    // Последовательный бой всегда идёт в одном потоке.
+    void setThreadCount(size_t count);
+    size_t getThreadCount() const;
+    
+    // Удаление мертвых NPC. Индексы живых могут измениться (на место
+    // погибшего переносится запись с конца), ссылки NPCHandle остаются верны.
     void removeDeadNPCs();
     
     // Получить количество NPC
-    size_t getNPCCount() const { return npcs.size(); }
+    size_t getNPCCount() const { return store.size(); }
+    
+    // Очистить всех NPC (арена объектов освобождается целиком)
+    void clear();
     
-    // Очистить всех NPC
-    void clear() { npcs.clear(); }
+    // Создать NPC в арене редактора (на карту не добавляется)
+    std::shared_ptr<NPC> createNPC(NPCType type, std::string_view name, double x, double y);
     
-    // Получить NPC по индексу
+    // Арена объектов NPC (например, для резервирования места под массовое создание)
+    NPCPool& getPool() { return pool; }
+    
+    // Получить NPC по индексу (объект связан с хранилищем редактора)
     std::shared_ptr<NPC> getNPC(size_t index) const;
+    
+    // Получить NPC по ссылке (nullptr, если NPC уже удалён)
+    std::shared_ptr<NPC> getNPC(NPCHandle handle) const;
+    
+    // Ссылка на NPC с данным индексом и проверка ссылки
+    NPCHandle getHandle(size_t index) const { return store.handle(index); }
+    bool isValid(NPCHandle handle) const { return store.isValid(handle); }
+    
+    // Пространственные запросы по индексу, который строится при первом
+    // запросе и дальше обновляется вместе с хранилищем. func(i) получает
+    // индекс NPC; порядок результатов не задан. Запросы можно делать из
+    // нескольких потоков, пока мир не меняется.
+    template <typename Func>
+    void queryRadius(double x, double y, double radius, Func&& func,
+                     const NPCFilter& filter = NPCFilter()) const {
+        if (!(radius >= 0)) {
+            return;
+        }
+        const double radiusSq = radius * radius;
+        queryIndex().forEachInRect(x - radius, y - radius, x + radius, y + radius, [&](size_t i) {
+            double dx = store.x(i) - x;
+            double dy = store.y(i) - y;
+            if (dx * dx + dy * dy <= radiusSq && filter.accepts(store, i)) {
+                func(i);
+            }
+        });
+    }
+    
+    template <typename Func>
+    void queryRect(const MapBounds& area, Func&& func, const NPCFilter& filter = NPCFilter()) const {
+        queryIndex().forEachInRect(area.minX, area.minY, area.maxX, area.maxY, [&](size_t i) {
+            if (store.x(i) >= area.minX && store.x(i) <= area.maxX &&
+                store.y(i) >= area.minY && store.y(i) <= area.maxY && filter.accepts(store, i)) {
+                func(i);
+            }
+        });
+    }
+    
+    // То же с записью индексов в out (не больше capacity). Возвращает число
+    // найденных NPC, которое может быть больше capacity.
+    size_t queryRadius(double x, double y, double radius, size_t* out, size_t capacity,
+                       const NPCFilter& filter = NPCFilter()) const;
+    size_t queryRect(const MapBounds& area, size_t* out, size_t capacity,
+                     const NPCFilter& filter = NPCFilter()) const;
+    
+    // До k ближайших к точке NPC в out по возрастанию расстояния (при равном
+    // расстоянии — по индексу). Возвращает их число.
+    size_t nearestK(double x, double y, size_t k, size_t* out,
+                    const NPCFilter& filter = NPCFilter()) const;
+    
+    // Прямой доступ к массивам NPC
+    const NPCStore& getStore() const { return store; }
 };
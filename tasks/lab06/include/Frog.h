@@ -3,7 +3,9 @@
 
 class Frog : public NPC {
 public:
-    Frog(const std::string& name, double x, double y);
-    void accept(BattleVisitor& visitor, NPC& other) override;
-    std::string getType() const override { return "Frog"; }
+    static constexpr NPCType TAG = NPCType::Frog;
+    static constexpr std::string_view NAME = "Frog";
+
+    Frog(std::string_view name, double x, double y);
+    std::string getType() const override { return std::string(NAME); }
 };
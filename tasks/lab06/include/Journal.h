@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include "NPCStore.h"
+
+// Параметры журнала изменений
+struct JournalOptions {
+    size_t groupCommit = 64;          // Записей в одной группе (1 — запись сразу)
+    bool durable = true;              // fsync после каждой группы
+    uint64_t compactBytes = 1 << 20;  // Порог сжатия журнала (0 — только вручную)
+};
+
+// Журнал изменений мира (write-ahead log) рядом со снимком WorldSnapshot.
+//
+//   PATH.snapshot      полный снимок на момент последнего сжатия
+//   PATH.log           "BF3J", u32 version, u64 id снимка, затем записи:
+//                      u32 size, u64 checksum, payload[size]
+//
+// Записи копятся в буфере и пишутся группами. Сжатие записывает новый снимок
+// и пустой журнал с его id; журнал с чужим id (сбой посреди сжатия) при
+// восстановлении отбрасывается, так как снимок уже содержит его изменения.
+// Оборванная последняя запись отбрасывается и обрезается.
+//
+// NPC в записях указываются по имени: имена в мире уникальны, а индексы
+// меняются при удалении погибших. Восстанавливаются те же живые NPC
+// (сжатие отбрасывает погибших), порядок в хранилище может отличаться.
+// Каталог синхронизируется после каждого переименования снимка и журнала.
+class Journal {
+public:
+    static constexpr char MAGIC[4] = {'B', 'F', '3', 'J'};
+    static constexpr uint32_t VERSION = 1;
+
+    enum class Op : uint8_t {
+        Add = 1,         // u8 type, f64 x, f64 y, имя
+        Kill = 2,        // имя
+        RemoveDead = 3,
+        Clear = 4
+    };
+
+private:
+    std::string snapshotPath;
+    std::string logPath;
+    JournalOptions options;
+
+    std::FILE* file = nullptr;
+    std::vector<char> pending;  // Записи текущей группы
+    size_t pendingRecords = 0;
+    uint64_t logBytes = 0;       // Размер журнала на диске
+    uint64_t snapshotBytes = 0;
+    size_t replayed = 0;
+
+    void append(Op op, NPCType type, std::string_view name, double x, double y);
+    size_t replay(std::string_view records, NPCStore& store);
+    bool startLog(uint64_t snapshotId);
+    bool syncFile(const std::string& filename) const;  // Файл или каталог
+    void closeFile();
+
+public:
+    Journal(const std::string& path, const JournalOptions& options = JournalOptions());
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Восстановить store: последний снимок и хвост журнала. Если ни снимка,
+    // ни журнала нет, текущее содержимое store становится первым снимком.
+    // При ошибке store не меняется.
+    bool open(NPCStore& store, std::string* error = nullptr);
+    bool isOpen() const { return file != nullptr; }
+
+    // Запись операций (группа пишется, когда набирается groupCommit записей)
+    void add(NPCType type, std::string_view name, double x, double y);
+    void kill(std::string_view name);
+    void removeDead();
+    void clear();
+
+    // Записать накопленную группу на диск
+    bool commit();
+
+    // Пора ли сжимать: журнал больше и порога, и самого снимка
+    bool needsCompaction() const;
+
+    // Заменить снимок состоянием store и начать пустой журнал
+    bool compact(const NPCStore& store);
+
+    size_t getPendingCount() const { return pendingRecords; }
+    size_t getReplayedCount() const { return replayed; }
+    uint64_t getLogBytes() const { return logBytes; }
+};
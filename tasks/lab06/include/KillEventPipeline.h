@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include "Observer.h"
+
+// Что делать, если очередь событий заполнена
+enum class Backpressure {
+    Block,  // Боевой цикл ждёт, пока потребитель освободит место
+    Drop    // Событие отбрасывается и учитывается в droppedCount()
+};
+
+// Асинхронная доставка событий: ограниченная lock-free очередь
+// с одним производителем (боевой цикл) и одним потребителем
+// (отдельный поток, вызывающий sink). Порядок событий сохраняется.
+// Потребитель на пустой очереди засыпает на условной переменной;
+// мьютекс берётся, только когда его нужно разбудить.
+class KillEventPipeline {
+public:
+    using Sink = std::function<void(const KillEvent&)>;
+
+    KillEventPipeline(size_t capacity, Backpressure policy, Sink sink);
+    ~KillEventPipeline();
+
+    KillEventPipeline(const KillEventPipeline&) = delete;
+    KillEventPipeline& operator=(const KillEventPipeline&) = delete;
+
+    // Поставить событие в очередь (только из потока-производителя).
+    // false, если событие отброшено политикой Drop.
+    bool push(const KillEvent& event);
+
+    // Дождаться, пока потребитель обработает все поставленные события
+    void drain();
+
+    size_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    size_t capacity() const { return ring.size(); }
+
+private:
+    std::vector<KillEvent> ring;
+    size_t mask;
+    Backpressure policy;
+    Sink sink;
+
+    // Счётчики на разных кэш-линиях: head пишет потребитель, tail — производитель
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> dropped{0};
+    std::atomic<bool> stopping{false};
+
+    // Сон потребителя: parked выставляется под parkMutex перед ожиданием
+    std::atomic<bool> parked{false};
+    std::mutex parkMutex;
+    std::condition_variable wake;
+
+    std::thread consumer;
+
+    void consume();
+    // Разбудить потребителя, если он спит
+    void wakeConsumer();
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// Файл, отображённый в память только для чтения.
+// На POSIX-системах используется mmap; иначе файл читается в буфер целиком.
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> buffer;  // Запасной путь без mmap
+
+    void release();
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Открыть файл; false, если его не удалось открыть
+    bool open(const std::string& filename);
+
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(data, length); }
+};
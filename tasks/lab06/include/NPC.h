@@ -1,38 +1,72 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <memory>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
 
 class BattleVisitor;
+class NPCStore;
+
+// Компактный тег типа персонажа (индекс в таблице исходов боя)
+enum class NPCType : uint8_t {
+    Dragon = 0,
+    Bull = 1,
+    Frog = 2
+};
+
+constexpr size_t NPC_TYPE_COUNT = 3;
+
+// Имена типов, фабрика и диспетчеризация — в реестре NPCTypes.h
 
 class NPC {
 protected:
     std::string name;
     double x, y;
     bool alive;
+    NPCType type;
+
+private:
+    friend class NPCStore;
+
+    // Связь с хранилищем редактора, в которое добавлен NPC.
+    // При копировании NPC связь не переносится.
+    struct StoreLink {
+        NPCStore* store = nullptr;
+        size_t slot = 0;
+        StoreLink() = default;
+        StoreLink(const StoreLink&) {}
+        StoreLink& operator=(const StoreLink&) { return *this; }
+    } link;
 
 public:
-    NPC(const std::string& name, double x, double y);
+    NPC(std::string_view name, double x, double y, NPCType type);
     virtual ~NPC() = default;
 
     // Геттеры
-    std::string getName() const { return name; }
+    std::string_view getName() const { return name; }
     double getX() const { return x; }
     double getY() const { return y; }
     bool isAlive() const { return alive; }
+    NPCType getTypeTag() const { return type; }
     
-    // Установка статуса
-    void kill() { alive = false; }
+    // Установка статуса (передаётся в хранилище редактора, если NPC в нём)
+    void kill();
     
     // Расстояние до другого NPC
     double distanceTo(const NPC& other) const;
     
-    // Метод для паттерна Visitor
-    virtual void accept(BattleVisitor& visitor, NPC& other) = 0;
+    // Метод для паттерна Visitor: visitor.visit для конкретных типов пары
+    // (по таблице диспетчеризации реестра типов, без RTTI)
+    void accept(BattleVisitor& visitor, NPC& other);
     
     // Тип персонажа для сохранения
     virtual std::string getType() const = 0;
     
     // Строковое представление
     virtual std::string toString() const;
+    
+    // Строковое представление по полям (общее для NPC и хранилища)
+    static std::string format(NPCType type, std::string_view name, double x, double y);
 };
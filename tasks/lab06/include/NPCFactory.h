@@ -1,15 +1,49 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <string_view>
 #include "NPC.h"
 
+class NPCPool;
+
+// Поля одной строки текстового формата; name указывает в разбираемый текст
+struct NPCRecord {
+    NPCType type;
+    std::string_view name;
+    double x, y;
+};
+
 class NPCFactory {
 public:
     // Создание NPC по типу
     static std::shared_ptr<NPC> createNPC(const std::string& type, 
-                                          const std::string& name, 
+                                          std::string_view name, 
+                                          double x, double y);
+    
+    // Создание NPC по тегу типа
+    static std::shared_ptr<NPC> createNPC(NPCType type, 
+                                          std::string_view name, 
                                           double x, double y);
     
+    // Создание NPC в арене редактора (без выделения памяти на каждый объект)
+    static std::shared_ptr<NPC> createNPC(NPCType type, 
+                                          std::string_view name, 
+                                          double x, double y, 
+                                          NPCPool& pool);
+    
+    // Тег типа по имени из реестра типов ("Dragon", "Bull", "Frog")
+    static bool parseType(std::string_view typeName, NPCType& type);
+    
+    // Разбор строки "Type Name X Y" на месте: std::from_chars, без локали и выделений.
+    // Лишние поля в конце строки игнорируются, как и при чтении через поток.
+    // При ошибке в error (если передан) записывается причина.
+    static bool parseRecord(std::string_view line, NPCRecord& record, 
+                            const char** error = nullptr);
+    
+    // Разбор строки файла в поля без создания объекта
+    static bool parseLine(const std::string& line, NPCType& type, 
+                          std::string& name, double& x, double& y);
+    
     // Загрузка NPC из строки файла
     static std::shared_ptr<NPC> loadFromString(const std::string& line);
 };
@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <new>
+#include <utility>
+#include "NPC.h"
+#include "NPCTypes.h"
+
+// Слаб-пул объектов одного типа: объекты размещаются подряд в крупных блоках.
+// Память освобождается только целиком, при уничтожении пула.
+template <typename T>
+class SlabPool {
+private:
+    struct Slab {
+        T* data;
+        size_t capacity;
+        size_t used;
+    };
+
+    std::vector<Slab> slabs;
+    size_t current = 0;  // Слаб, в который идёт create; дальше — только пустые
+    size_t nextCapacity;
+    size_t count = 0;
+
+    void addSlab(size_t capacity) {
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        slabs.push_back({data, capacity, 0});
+    }
+
+public:
+    explicit SlabPool(size_t firstCapacity = 64) : nextCapacity(firstCapacity) {}
+
+    ~SlabPool() {
+        for (auto& slab : slabs) {
+            for (size_t k = 0; k < slab.used; ++k) {
+                slab.data[k].~T();
+            }
+            ::operator delete(slab.data);
+        }
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // Гарантировать место под следующие extra объектов: сначала остаток
+    // текущего слаба, на недостающие — один новый слаб
+    void reserve(size_t extra) {
+        size_t free = 0;
+        for (size_t k = current; k < slabs.size(); ++k) {
+            free += slabs[k].capacity - slabs[k].used;
+        }
+        if (free < extra) {
+            addSlab(extra - free);
+        }
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        while (current < slabs.size() && slabs[current].used == slabs[current].capacity) {
+            ++current;
+        }
+        if (current == slabs.size()) {
+            addSlab(nextCapacity);
+            nextCapacity *= 2;
+        }
+        Slab& slab = slabs[current];
+        T* object = new (slab.data + slab.used) T(std::forward<Args>(args)...);
+        ++slab.used;
+        ++count;
+        return object;
+    }
+
+    size_t size() const { return count; }
+    size_t slabCount() const { return slabs.size(); }
+    // Сколько объектов помещается во все слабы
+    size_t capacity() const {
+        size_t total = 0;
+        for (const auto& slab : slabs) {
+            total += slab.capacity;
+        }
+        return total;
+    }
+};
+
+// Арена для NPC редактора: отдельный слаб-пул на каждый тип из реестра.
+// Возвращаемые shared_ptr разделяют один счётчик ссылок на всю арену,
+// поэтому создание объекта не требует отдельного выделения памяти,
+// а арена живёт, пока на неё ссылается пул или хотя бы один объект.
+class NPCPool {
+private:
+    using Arena = NPCTypes::Each<SlabPool>;
+
+    std::shared_ptr<Arena> arena;
+
+    Arena& getArena();
+
+public:
+    // Создать NPC в арене
+    std::shared_ptr<NPC> create(NPCType type, std::string_view name, double x, double y);
+
+    // Подготовить место под count объектов типа одним выделением
+    void reserve(NPCType type, size_t count);
+
+    // Отпустить арену: память вернётся одним освобождением на слаб,
+    // когда исчезнут все внешние ссылки на объекты
+    void clear() { arena.reset(); }
+
+    // Число объектов в текущей арене
+    size_t size() const;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "NPC.h"
+#include "NameTable.h"
+#include "BattleRules.h"
+#include "DynamicGrid.h"
+
+class NPCPool;
+
+// Устойчивая ссылка на NPC хранилища: номер ячейки и её поколение.
+// Индекс NPC меняется при удалении погибших, а ссылка остаётся действительной,
+// пока не удалён именно этот NPC; после этого поколение ячейки не совпадает.
+struct NPCHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const NPCHandle& other) const {
+        return slot == other.slot && generation == other.generation;
+    }
+    bool operator!=(const NPCHandle& other) const { return !(*this == other); }
+};
+
+// Хранилище NPC в виде параллельных массивов (structure of arrays).
+// Боевой режим, печать и сохранение идут по плотным массивам координат,
+// типов и флагов жизни, не трогая отдельные объекты в куче.
+// Объекты NPC создаются только по запросу (view) и остаются связаны
+// с хранилищем: kill() у объекта меняет флаг жизни в хранилище и наоборот.
+class NPCStore {
+private:
+    std::vector<double> xs, ys;
+    std::vector<NPCType> types;
+    std::vector<uint8_t> alive;
+    std::vector<NameId> nameIds;
+    std::vector<uint32_t> slotOf;  // Ячейка ссылки для каждого NPC
+
+    // Ячейки ссылок: индекс NPC и поколение; свободные ячейки переиспользуются
+    std::vector<uint32_t> indexOfSlot;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeSlots;
+
+    // Таблица имён мира: записи хранят только номера имён
+    NameTable names;
+
+    // Объекты NPC для совместимости (пустые, пока не запрошены)
+    mutable std::vector<std::shared_ptr<NPC>> views;
+
+    // Куда записывать индексы убитых (для журнала; нет — не записывать)
+    std::vector<uint32_t>* killLog = nullptr;
+
+    // Пространственный индекс по номерам NPC (нет — ещё не запрошен).
+    // Строится под spatialMutex; spatialBuilt выставляется после постройки.
+    mutable std::unique_ptr<DynamicGrid> spatial;
+    mutable std::mutex spatialMutex;
+    mutable std::atomic<bool> spatialBuilt{false};
+
+    void attach(const std::shared_ptr<NPC>& npc, size_t slot) const;
+    static void detach(NPC& npc);
+    uint32_t acquireSlot(size_t index);
+    size_t append(NPCType type, NameId name, double x, double y);
+    void moveEntry(size_t from, size_t to);
+    void popBack();
+
+public:
+    NPCStore() = default;
+    ~NPCStore();
+
+    // Объекты NPC хранят указатель на хранилище, поэтому оно не копируется
+    NPCStore(const NPCStore&) = delete;
+    NPCStore& operator=(const NPCStore&) = delete;
+
+    size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+    void reserve(size_t count);
+    // Под сколько NPC выделены массивы
+    size_t capacity() const { return xs.capacity(); }
+
+    // Добавить NPC по полям
+    size_t add(NPCType type, std::string_view name, double x, double y);
+
+    // Добавить NPC с именем, которого ещё нет в хранилище; иначе npos
+    size_t addUnique(NPCType type, std::string_view name, double x, double y);
+
+    // Добавить существующий объект; он остаётся связан с хранилищем
+    size_t add(const std::shared_ptr<NPC>& npc);
+
+    // Доступ к полям
+    double x(size_t i) const { return xs[i]; }
+    double y(size_t i) const { return ys[i]; }
+    NPCType type(size_t i) const { return types[i]; }
+    bool isAlive(size_t i) const { return alive[i] != 0; }
+    std::string_view name(size_t i) const { return names.text(nameIds[i]); }
+    NameId nameId(size_t i) const { return nameIds[i]; }
+    const NameTable& nameTable() const { return names; }
+
+    // Ссылка на NPC с индексом i и обратное преобразование
+    NPCHandle handle(size_t i) const { return {slotOf[i], generations[slotOf[i]]}; }
+    bool isValid(NPCHandle h) const {
+        return h.slot < generations.size() && generations[h.slot] == h.generation;
+    }
+    // Индекс NPC по ссылке; npos, если NPC уже удалён
+    size_t indexOf(NPCHandle h) const { return isValid(h) ? indexOfSlot[h.slot] : npos; }
+
+    static constexpr size_t npos = SIZE_MAX;
+
+    // Плотные массивы для пакетной обработки
+    const std::vector<double>& xData() const { return xs; }
+    const std::vector<double>& yData() const { return ys; }
+    const std::vector<NPCType>& typeData() const { return types; }
+    const std::vector<uint8_t>& aliveData() const { return alive; }
+
+    // Есть ли в хранилище NPC с таким именем (O(1), без выделений памяти)
+    bool containsName(std::string_view name) const { return names.contains(name); }
+
+    // Пометить NPC погибшим. Построенный пространственный индекс при этом
+    // меняется, так что из нескольких потоков сразу kill() не вызывается.
+    void kill(size_t i);
+
+    // Применить исход боя к паре; false, если бой не состоялся
+    // (кто-то из пары уже мёртв или исход None)
+    bool applyOutcome(size_t attacker, size_t defender, BattleOutcome outcome);
+
+    // Записывать индексы убитых в log (nullptr — перестать). kill() при этом
+    // нельзя вызывать из нескольких потоков одновременно.
+    void setKillLog(std::vector<uint32_t>* log) { killLog = log; }
+
+    // Переместить NPC (объект NPC, если создан, тоже получает новые координаты)
+    void setPosition(size_t i, double x, double y);
+
+    // Пространственный индекс: строится при первом вызове по сетке bounds
+    // с клеткой не меньше cellSize (параметры следующих вызовов не важны)
+    // и дальше обновляется при добавлении, перемещении и удалении NPC
+    // (погибшие откладываются: DynamicGrid::park).
+    // Запросы из нескольких потоков безопасны, в том числе первый, пока
+    // хранилище не меняется.
+    const DynamicGrid& spatialIndex(const MapBounds& bounds, double cellSize) const;
+
+    // Удалить погибших: на место каждого переносится запись с конца (без сдвига
+    // массивов). Записи [0, prefix) остаются в начале — дыра в этой части
+    // закрывается её последней записью. Возвращает новый размер этой части.
+    size_t removeDead(size_t prefix = 0);
+
+    void clear();
+
+    // Объект NPC для слота i (создаётся при первом обращении)
+    std::shared_ptr<NPC> view(size_t i) const;
+    
+    // То же, с созданием объекта в арене
+    std::shared_ptr<NPC> view(size_t i, NPCPool& pool) const;
+};
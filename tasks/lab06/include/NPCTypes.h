@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#include "NPC.h"
+#include "Dragon.h"
+#include "Bull.h"
+#include "Frog.h"
+#include "BattleVisitor.h"
+
+// Список типов для метапрограммирования
+template <typename... Ts>
+struct TypeList {
+    static constexpr size_t size = sizeof...(Ts);
+};
+
+template <typename T>
+struct TypeTag {
+    using type = T;
+};
+
+// Реестр типов NPC: порядок в списке совпадает с тегами NPCType.
+// Новый тип добавляется сюда одной строкой (класс с TAG и NAME, тег в NPCType
+// и строка в BATTLE_OUTCOMES); фабрика, арена, разбор имён типов
+// и таблица двойной диспетчеризации строятся по списку при компиляции.
+using NPCTypeList = TypeList<Dragon, Bull, Frog>;
+
+template <typename List>
+class NPCTypeRegistry;
+
+template <typename... Ts>
+class NPCTypeRegistry<TypeList<Ts...>> {
+public:
+    static constexpr size_t COUNT = sizeof...(Ts);
+
+    // Имена типов в формате файла сохранения (по тегу)
+    static constexpr std::array<std::string_view, COUNT> NAMES = {{Ts::NAME...}};
+
+private:
+    static constexpr bool tagsFollowOrder() {
+        size_t index = 0;
+        bool ok = true;
+        ((ok = ok && static_cast<size_t>(Ts::TAG) == index++), ...);
+        return ok;
+    }
+    static_assert(COUNT == NPC_TYPE_COUNT, "реестр должен перечислять все теги NPCType");
+    static_assert(tagsFollowOrder(), "порядок реестра должен совпадать с тегами NPCType");
+
+    // Совершенный хеш имён типов: затравка FNV-1a подбирается при компиляции
+    // так, чтобы все имена попали в разные корзины
+    static constexpr size_t BUCKETS = [] {
+        size_t buckets = 1;
+        while (buckets < 2 * COUNT) {
+            buckets *= 2;
+        }
+        return buckets;
+    }();
+
+    static constexpr uint32_t hash(std::string_view text, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : text) {
+            h = (h ^ (unsigned char)c) * 16777619u;
+        }
+        return h;
+    }
+
+    static constexpr uint32_t findSeed() {
+        for (uint32_t seed = 0; seed < 100000; ++seed) {
+            bool used[BUCKETS] = {};
+            bool ok = true;
+            for (size_t t = 0; t < COUNT && ok; ++t) {
+                size_t bucket = hash(NAMES[t], seed) & (BUCKETS - 1);
+                ok = !used[bucket];
+                used[bucket] = true;
+            }
+            if (ok) {
+                return seed;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    static constexpr uint32_t SEED = findSeed();
+    static_assert(SEED != UINT32_MAX, "не найден совершенный хеш имён типов");
+
+    // Корзина -> тег + 1 (0 — пустая корзина)
+    static constexpr std::array<uint8_t, BUCKETS> makeBuckets() {
+        std::array<uint8_t, BUCKETS> table{};
+        for (size_t t = 0; t < COUNT; ++t) {
+            table[hash(NAMES[t], SEED) & (BUCKETS - 1)] = (uint8_t)(t + 1);
+        }
+        return table;
+    }
+
+    static constexpr std::array<uint8_t, BUCKETS> BUCKET_TAGS = makeBuckets();
+
+    // Таблица двойной диспетчеризации: [нападающий][защищающийся]
+    using Visit = void (*)(BattleVisitor&, NPC&, NPC&);
+
+    template <typename Attacker, typename Defender>
+    static void visitPair(BattleVisitor& visitor, NPC& attacker, NPC& defender) {
+        visitor.visit(static_cast<Attacker&>(attacker), static_cast<Defender&>(defender));
+    }
+
+    template <typename Attacker>
+    static constexpr std::array<Visit, COUNT> visitRow() {
+        return {{&visitPair<Attacker, Ts>...}};
+    }
+
+    static constexpr std::array<std::array<Visit, COUNT>, COUNT> VISITS = {{visitRow<Ts>()...}};
+
+    template <typename F, size_t... I>
+    static void forTypeImpl(size_t tag, F& func, std::index_sequence<I...>) {
+        ((tag == I ? (func(TypeTag<Ts>()), true) : false) || ...);
+    }
+
+public:
+    // Кортеж Holder<T> для каждого типа (например, пулы объектов)
+    template <template <typename> class Holder>
+    using Each = std::tuple<Holder<Ts>...>;
+
+    // Вызвать func(TypeTag<T>()) для типа с данным тегом
+    template <typename F>
+    static void forType(NPCType type, F&& func) {
+        forTypeImpl(static_cast<size_t>(type), func, std::index_sequence_for<Ts...>());
+    }
+
+    // Вызвать func(TypeTag<T>()) для каждого типа по порядку тегов
+    template <typename F>
+    static void forEachType(F&& func) {
+        (func(TypeTag<Ts>()), ...);
+    }
+
+    static constexpr std::string_view name(NPCType type) {
+        return NAMES[static_cast<size_t>(type)];
+    }
+
+    // Тег по имени: хеш и одно сравнение с именем из найденной корзины
+    static bool parse(std::string_view text, NPCType& type) {
+        uint8_t entry = BUCKET_TAGS[hash(text, SEED) & (BUCKETS - 1)];
+        if (entry == 0 || NAMES[entry - 1] != text) {
+            return false;
+        }
+        type = static_cast<NPCType>(entry - 1);
+        return true;
+    }
+
+    // Объект NPC по тегу
+    static std::shared_ptr<NPC> create(NPCType type, std::string_view name, double x, double y) {
+        std::shared_ptr<NPC> npc;
+        forType(type, [&](auto tag) {
+            npc = std::make_shared<typename decltype(tag)::type>(name, x, y);
+        });
+        return npc;
+    }
+
+    // Бой пары NPC: visitor.visit для их конкретных типов
+    static void dispatch(BattleVisitor& visitor, NPC& attacker, NPC& defender) {
+        VISITS[static_cast<size_t>(attacker.getTypeTag())][static_cast<size_t>(defender.getTypeTag())](
+            visitor, attacker, defender);
+    }
+};
+
+using NPCTypes = NPCTypeRegistry<NPCTypeList>;
+
+// Имя типа в формате файла сохранения
+inline std::string_view npcTypeName(NPCType type) {
+    return NPCTypes::name(type);
+}
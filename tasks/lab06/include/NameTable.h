@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Номер имени в таблице имён
+using NameId = uint32_t;
+
+// Таблица интернированных имён: каждое имя хранится один раз,
+// NPC и события ссылаются на него компактным номером.
+// На имя считаются ссылки; освободившиеся номера используются повторно.
+//
+// Новые имена не трогают уже записанных: text() выданного номера можно
+// читать из другого потока (например, из потока доставки событий), пока
+// таблица пополняется, если номер передан ему после записи имени.
+// Освобождение имён и clear() так читать нельзя.
+class NameTable {
+private:
+    // Имена лежат в блоках по 64, 128, 256... строк: блок k начинается
+    // с номера 64 * (2^k - 1). Блоки не перемещаются и не перевыделяются,
+    // а массив указателей на них фиксирован, поэтому рост таблицы не меняет
+    // ничего, что читает text(), и на строки можно держать string_view.
+    static constexpr size_t FIRST_BLOCK = 64;
+    static constexpr size_t MAX_BLOCKS = 27;  // Хватает на все 2^32 номеров NameId
+
+    std::unique_ptr<std::string[]> blocks[MAX_BLOCKS];
+    size_t count = 0;  // Занятые номера [0, count)
+    std::vector<uint32_t> refs;
+    std::vector<NameId> freeIds;
+
+    // Хеш-индекс: имя -> номер. Ключи указывают в names,
+    // поэтому поиск по string_view ничего не выделяет.
+    std::unordered_map<std::string_view, NameId> index;
+
+    // Новое имя, которого точно нет в индексе
+    NameId insert(std::string_view name);
+    // Место под имя (одна ссылка), в индекс оно не попадает
+    NameId place(std::string_view name);
+
+    static size_t blockOf(NameId id) {
+        return 63 - __builtin_clzll((uint64_t)id / FIRST_BLOCK + 1);
+    }
+    const std::string& slot(NameId id) const {
+        const size_t block = blockOf(id);
+        return blocks[block][id - FIRST_BLOCK * ((size_t(1) << block) - 1)];
+    }
+    std::string& slot(NameId id) {
+        return const_cast<std::string&>(static_cast<const NameTable*>(this)->slot(id));
+    }
+
+public:
+    // Номер имени (+1 ссылка); новое имя добавляется в таблицу
+    NameId intern(std::string_view name);
+
+    // Добавить имя, которого ещё нет в таблице (одна ссылка); false и без
+    // изменений, если оно уже есть. Один поиск в хеше вместо contains + intern:
+    // имя копируется до поиска, и для уже известного имени копия пропадает.
+    bool internNew(std::string_view name, NameId& id);
+
+    // Снять ссылку; имя без ссылок удаляется из таблицы
+    void release(NameId id);
+
+    // Номер уже известного имени (без изменения счётчика ссылок)
+    bool find(std::string_view name, NameId& id) const;
+
+    bool contains(std::string_view name) const { return index.count(name) != 0; }
+
+    // Текст имени; действителен, пока у имени есть ссылки
+    std::string_view text(NameId id) const { return slot(id); }
+
+    // Число различных имён в таблице
+    size_t size() const { return index.size(); }
+
+    void reserve(size_t count) { index.reserve(count); }
+    void clear();
+};
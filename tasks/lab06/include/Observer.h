@@ -1,23 +1,82 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <cstdio>
+#include <cstddef>
+#include <iosfwd>
+#include "NameTable.h"
+
+// Событие убийства. Участники передаются номерами в таблице имён мира;
+// текст нужен только наблюдателям, которые его печатают.
+// Таблица должна жить, пока событие не доставлено.
+struct KillEvent {
+    const NameTable* names = nullptr;
+    NameId killer = 0;
+    NameId victim = 0;
+    bool mutual = false;  // Погибли оба участника
+
+    std::string_view killerName() const { return names->text(killer); }
+    std::string_view victimName() const { return names->text(victim); }
+
+    // Текст события: "A убил B" или "A и B убил друг друга"
+    void appendText(std::string& out) const;
+};
 
 class BattleObserver {
 public:
     virtual ~BattleObserver() = default;
-    virtual void onKill(const std::string& killer, const std::string& victim) = 0;
+    virtual void onKill(const KillEvent& event) = 0;
+    
+    // Бой завершён (буферизующие наблюдатели сбрасывают данные)
+    virtual void onBattleEnd() {}
 };
 
+// Печать событий в поток (по умолчанию std::cout)
 class ConsoleObserver : public BattleObserver {
+private:
+    std::ostream& out;
+    std::string line;  // Строка события (память переиспользуется)
+    
 public:
-    void onKill(const std::string& killer, const std::string& victim) override;
+    ConsoleObserver();
+    explicit ConsoleObserver(std::ostream& out) : out(out) {}
+
+    void onKill(const KillEvent& event) override;
 };
 
+// Когда FileObserver вызывает fsync
+enum class FsyncPolicy {
+    Never,    // Данные остаются в кэше ОС
+    OnFlush   // fsync после каждого сброса буфера
+};
+
+// Запись событий в файл: файл открыт всё время жизни наблюдателя,
+// события копятся в буфере и сбрасываются при его заполнении,
+// в конце боя и при уничтожении наблюдателя
 class FileObserver : public BattleObserver {
 private:
     std::string filename;
+    std::FILE* file = nullptr;
+    std::string buffer;
+    size_t flushThreshold;
+    FsyncPolicy fsyncPolicy;
     
 public:
-    FileObserver(const std::string& filename);
-    void onKill(const std::string& killer, const std::string& victim) override;
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+    
+    FileObserver(const std::string& filename, 
+                 size_t bufferSize = DEFAULT_BUFFER_SIZE, 
+                 FsyncPolicy fsyncPolicy = FsyncPolicy::Never);
+    ~FileObserver() override;
+    
+    FileObserver(const FileObserver&) = delete;
+    FileObserver& operator=(const FileObserver&) = delete;
+    
+    void onKill(const KillEvent& event) override;
+    void onBattleEnd() override;
+    
+    // Записать накопленные события в файл
+    void flush();
+    
+    bool isOpen() const { return file != nullptr; }
 };
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Пакетная проверка дальности: одна точка против блока кандидатов.
+// Сравниваются квадраты расстояний с rangeSq, без извлечения корня.
+// Результат — битовая маска: бит k слова mask[k / 64] равен 1,
+// если кандидат k находится не дальше радиуса.
+// В mask должно быть не меньше rangeMaskWords(count) слов.
+void rangeMask(double x, double y,
+               const double* xs, const double* ys, size_t count,
+               double rangeSq, uint64_t* mask);
+
+// Скалярная версия (эталон для тестов и запасной путь без SIMD)
+void rangeMaskScalar(double x, double y,
+                     const double* xs, const double* ys, size_t count,
+                     double rangeSq, uint64_t* mask);
+
+// Число 64-битных слов маски для count кандидатов
+inline size_t rangeMaskWords(size_t count) {
+    return (count + 63) / 64;
+}
+
+// Имя используемой реализации ("avx2", "sse2" или "scalar")
+const char* rangeMaskBackend();
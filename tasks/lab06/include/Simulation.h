@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "NPCStore.h"
+
+class Editor;
+class BattleVisitor;
+
+// Как NPC выбирают направление движения
+enum class MovementMode {
+    RandomWalk,  // Случайный шаг на каждом такте
+    Waypoint     // Движение к случайной цели; у цели выбирается новая
+};
+
+struct SimulationConfig {
+    double timeStep = 1.0 / 30;  // Длительность такта, с
+    double speed = 5.0;          // Скорость NPC, м/с
+    double range = 10.0;         // Радиус боя
+    MovementMode movement = MovementMode::RandomWalk;
+    uint64_t seed = 1;           // Зерно генератора (результат воспроизводим)
+};
+
+// Время и итоги одного такта
+struct TickTiming {
+    std::chrono::nanoseconds moveTime{0};    // Движение и обновление индекса
+    std::chrono::nanoseconds battleTime{0};  // Поиск пар и бои
+    size_t kills = 0;
+    size_t alive = 0;                        // Живых после такта
+};
+
+// Симуляция с фиксированным шагом над миром редактора:
+// на каждом такте живые NPC двигаются, затем разрешаются бои.
+// NPC двигаются через Editor::moveNPC, пары ищутся по индексу хранилища
+// (Editor::resolveMoving) в порядке (i, j), как в BattleEngine::resolve.
+// Отрицательный радиус (или NaN) не допускает ни одной пары.
+// Погибшие остаются в мире до removeDeadNPCs. Если у редактора включён
+// журнал, после run он сжимается в снимок.
+class Simulation {
+private:
+    Editor& editor;
+    SimulationConfig config;
+    // Цели режима Waypoint по слотам ссылок NPC: индексы меняются при
+    // removeDeadNPCs, а слот остаётся за NPC. targetOf — чья это цель
+    // (чужая или пустая ссылка — цели ещё нет).
+    std::vector<double> targetX, targetY;
+    std::vector<NPCHandle> targetOf;
+    uint64_t rngState;
+    std::vector<TickTiming> timings;
+
+    double random01();
+    void prepare();
+    void moveAll();
+
+public:
+    Simulation(Editor& editor, const SimulationConfig& config);
+
+    // Выполнить ticks тактов; события уходят в visitor
+    void run(size_t ticks, BattleVisitor& visitor);
+
+    // Время по тактам за все вызовы run
+    const std::vector<TickTiming>& getTimings() const { return timings; }
+
+    const SimulationConfig& getConfig() const { return config; }
+};
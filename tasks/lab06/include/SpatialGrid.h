@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// Прямоугольная область карты
+struct MapBounds {
+    double minX, minY;
+    double maxX, maxY;
+};
+
+// Равномерная сетка для поиска соседей в боевом режиме.
+// Точки раскладываются по клеткам со стороной не меньше радиуса боя,
+// поэтому все соседи в пределах радиуса лежат в своей или соседних клетках.
+class SpatialGrid {
+private:
+    double minX, minY;
+    double cellSize;
+    size_t width, height;
+
+    // Индексы точек, упорядоченные по клеткам (строка за строкой).
+    // Точки клетки c лежат в items[cellStart[c] .. cellStart[c + 1]).
+    std::vector<size_t> cellStart;
+    std::vector<size_t> items;
+    // Координаты точек в том же порядке, что и items (для пакетной проверки дальности)
+    std::vector<double> itemX, itemY;
+
+    size_t cellCoord(double value, double origin, size_t cells) const;
+
+public:
+    // Ограничение на число клеток по одной оси (для очень малых радиусов)
+    static constexpr size_t MAX_CELLS_PER_AXIS = 256;
+
+    SpatialGrid(double minX, double minY, double maxX, double maxY, double range);
+    SpatialGrid(const MapBounds& bounds, double range)
+        : SpatialGrid(bounds.minX, bounds.minY, bounds.maxX, bounds.maxY, range) {}
+
+    // Разложить точки по клеткам; внутри клетки индексы идут по возрастанию
+    void build(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    size_t getWidth() const { return width; }
+    size_t getHeight() const { return height; }
+    double getCellSize() const { return cellSize; }
+
+    // Обход клетки точки (x, y) и восьми соседних непрерывными блоками:
+    // func(indices, xs, ys, count) вызывается для каждой из (до) трёх строк клеток
+    template <typename Func>
+    void forEachNeighbourBlock(double x, double y, Func&& func) const {
+        size_t cx = cellCoord(x, minX, width);
+        size_t cy = cellCoord(y, minY, height);
+        size_t x0 = cx > 0 ? cx - 1 : 0;
+        size_t x1 = cx + 1 < width ? cx + 1 : cx;
+        size_t y0 = cy > 0 ? cy - 1 : 0;
+        size_t y1 = cy + 1 < height ? cy + 1 : cy;
+
+        // Клетки одной строки идут в items подряд
+        for (size_t row = y0; row <= y1; ++row) {
+            size_t begin = cellStart[row * width + x0];
+            size_t end = cellStart[row * width + x1 + 1];
+            if (begin < end) {
+                func(items.data() + begin, itemX.data() + begin, itemY.data() + begin, end - begin);
+            }
+        }
+    }
+
+    // Обход индексов из клетки точки (x, y) и восьми соседних
+    template <typename Func>
+    void forEachNeighbour(double x, double y, Func&& func) const {
+        forEachNeighbourBlock(x, y, [&](const size_t* indices, const double*, const double*, size_t count) {
+            for (size_t k = 0; k < count; ++k) {
+                func(indices[k]);
+            }
+        });
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// Пул рабочих потоков для параллельных проходов боевого режима.
+// parallelFor раздаёт индексы задач динамически; вызывающий поток тоже работает.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Текущее задание
+    const std::function<void(size_t)>* task = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextIndex{0};
+    size_t generation = 0;
+    size_t busy = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runTasks();
+
+public:
+    // threads — общее число потоков, включая вызывающий
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Выполнить func(k) для всех k из [0, count) и дождаться завершения
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+};
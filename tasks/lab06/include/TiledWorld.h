@@ -0,0 +1,125 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include "NPCStore.h"
+#include "SpatialGrid.h"
+
+class BattleVisitor;
+
+struct TiledWorldConfig {
+    std::string directory;            // Каталог файлов плиток
+    double tileSize = 500.0;          // Сторона плитки (по умолчанию — карта редактора)
+    size_t tilesX = 64, tilesY = 64;  // Размер мира в плитках
+    size_t memoryBudget = 64 << 20;   // Байт на загруженные плитки (по оценке BYTES_PER_NPC)
+};
+
+// Большой мир из плиток. Каждая плитка — отдельное хранилище NPC,
+// которое сохраняется в свой снимок DIR/tile_X_Y.bin (WorldSnapshot)
+// и загружается при первом обращении: добавлении, бое или запросе.
+// Когда загруженные плитки превышают бюджет памяти, давно не использованные
+// выгружаются (изменённые перед этим сохраняются).
+//
+// Имена уникальны в пределах плитки. Погибшие остаются в загруженной плитке
+// до removeDeadNPCs или выгрузки: в снимок попадают только живые.
+class TiledWorld {
+public:
+    // Оценка памяти на один NPC: массивы хранилища, имя и его запись в таблице
+    static constexpr size_t BYTES_PER_NPC = 128;
+
+private:
+    struct Tile {
+        NPCStore store;
+        bool dirty = false;
+        bool broken = false;                  // Файл не прочитан: плитка не меняется и не сохраняется
+        size_t pins = 0;                      // Плитку сейчас нельзя выгрузить
+        std::list<uint64_t>::iterator recent;  // Место в списке lru
+    };
+
+    TiledWorldConfig config;
+    std::unordered_map<uint64_t, std::unique_ptr<Tile>> resident;
+    std::list<uint64_t> lru;  // Ключи загруженных плиток, в начале — последние
+    std::set<uint64_t> known;  // Плитки с NPC (на диске или в памяти) в порядке ключей
+    size_t loads = 0;
+    size_t evictions = 0;
+    std::string lastError;
+
+    // Ключ плитки: номер по строкам (ty * tilesX + tx)
+    uint64_t keyOf(size_t tx, size_t ty) const { return (uint64_t)ty * config.tilesX + tx; }
+    std::string tilePath(uint64_t key) const;
+    MapBounds tileBounds(uint64_t key) const;
+
+    // Загруженная плитка (при необходимости читается с диска); становится последней в lru
+    Tile& acquire(uint64_t key);
+    bool saveTile(uint64_t key, Tile& tile);
+    // Выгрузить давно не использованные плитки, пока память больше бюджета
+    void evictOverBudget();
+    // Плитки, задетые прямоугольником; false, если он целиком вне мира
+    bool tileRange(const MapBounds& area, size_t& tx0, size_t& ty0, size_t& tx1, size_t& ty1) const;
+
+public:
+    // Плитки, уже лежащие в каталоге, становятся известны сразу, но не загружаются
+    explicit TiledWorld(const TiledWorldConfig& config);
+    // Изменённые плитки сохраняются
+    ~TiledWorld();
+
+    TiledWorld(const TiledWorld&) = delete;
+    TiledWorld& operator=(const TiledWorld&) = delete;
+
+    MapBounds getBounds() const;
+
+    // Добавить NPC; false, если точка вне мира или имя уже занято в плитке
+    bool addNPC(NPCType type, std::string_view name, double x, double y);
+
+    // Боевой режим по всему миру. Плитки обходятся по порядку ключей; в памяти
+    // одновременно нужны плитка и её соседи справа и снизу. Пары идут в том же
+    // порядке, что и в одном хранилище, где NPC упорядочены по плиткам.
+    // Радиус не больше стороны плитки; иначе false.
+    bool startBattle(double range, BattleVisitor& visitor);
+
+    // Обход живых NPC в прямоугольнике: func(store, i); задетые плитки загружаются
+    template <typename Func>
+    void forEachNPC(const MapBounds& area, Func&& func) {
+        size_t tx0, ty0, tx1, ty1;
+        if (!tileRange(area, tx0, ty0, tx1, ty1)) {
+            return;
+        }
+        for (size_t ty = ty0; ty <= ty1; ++ty) {
+            for (size_t tx = tx0; tx <= tx1; ++tx) {
+                uint64_t key = keyOf(tx, ty);
+                if (known.count(key) == 0) {
+                    continue;
+                }
+                Tile& tile = acquire(key);
+                ++tile.pins;
+                const NPCStore& store = tile.store;
+                for (size_t i = 0; i < store.size(); ++i) {
+                    if (store.isAlive(i) && store.x(i) >= area.minX && store.x(i) <= area.maxX &&
+                        store.y(i) >= area.minY && store.y(i) <= area.maxY) {
+                        func(store, i);
+                    }
+                }
+                --tile.pins;
+                evictOverBudget();
+            }
+        }
+    }
+
+    // Удалить погибших из загруженных плиток
+    void removeDeadNPCs();
+
+    // Сохранить все изменённые плитки
+    bool flush();
+
+    size_t getKnownTileCount() const { return known.size(); }
+    size_t getResidentTileCount() const { return resident.size(); }
+    size_t getResidentBytes() const;
+    size_t getLoadCount() const { return loads; }
+    size_t getEvictionCount() const { return evictions; }
+    // Причина последней ошибки чтения плитки
+    const std::string& getLastError() const { return lastError; }
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "NPCStore.h"
+
+// Двоичный снимок мира (версия 1). Все числа — little-endian.
+//
+//   "BF3W"             сигнатура
+//   u32 version        версия формата
+//   u64 count          число NPC
+//   u32 typeCount      таблица типов: u8 длина + имя типа
+//   u64 namesSize      таблица строк: имена подряд, затем u32 смещения (count + 1)
+//   u8  types[count]   номера в таблице типов
+//   f64 xs[count], f64 ys[count]  (выровнены на 8 байт)
+//   u64 checksum       контрольная сумма всех предыдущих байт
+//
+// Сохраняются только живые NPC, как и в текстовом формате.
+class WorldSnapshot {
+public:
+    static constexpr char MAGIC[4] = {'B', 'F', '3', 'W'};
+    static constexpr uint32_t VERSION = 1;
+
+    // Начинаются ли данные с сигнатуры снимка
+    static bool isSnapshot(std::string_view data);
+
+    // Записать живых NPC хранилища в файл
+    static bool save(const NPCStore& store, const std::string& filename);
+
+    // Загрузить снимок вместо содержимого хранилища. Данные проверяются целиком
+    // до изменения хранилища; при ошибке в error записывается причина,
+    // а в record — номер записи с пустым или повторным именем (с 1; 0 — снимок целиком).
+    static bool load(std::string_view data, NPCStore& store, std::string* error = nullptr,
+                     size_t* record = nullptr);
+
+    // Контрольная сумма снимка (64-битный хеш по словам)
+    static uint64_t checksum(const char* data, size_t size);
+};
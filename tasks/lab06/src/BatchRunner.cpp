@@ -0,0 +1,220 @@
+#include "BatchRunner.h"
+#include "Editor.h"
+#include "Observer.h"
+#include "BattleStats.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+// Радиус боя: неотрицательное конечное число
+bool parseRange(std::string_view text, double& range) {
+    double value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() ||
+        !(value >= 0) || !std::isfinite(value)) {
+        return false;
+    }
+    range = value;
+    return true;
+}
+
+bool parseCount(std::string_view text, size_t& count) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), count);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Обработка одного сценария; итог и ошибки пишутся в report
+bool runScenario(const BatchScenario& scenario, const BatchOptions& options, std::ostream& report) {
+    Editor editor;
+    const std::string title = scenario.load.empty() ? "<пустой мир>" : scenario.load;
+
+    if (!scenario.load.empty()) {
+        std::vector<LoadError> errors;
+        if (!editor.loadFromFile(scenario.load, &errors)) {
+            report << title << ": ошибка загрузки";
+            if (!errors.empty()) {
+                report << " (" << errors.front().message << ")";
+            }
+            report << "\n";
+            return false;
+        }
+        if (!errors.empty() && !options.quiet) {
+            report << title << ": пропущено строк: " << errors.size() << "\n";
+        }
+    }
+
+    size_t deadBefore = 0;
+    size_t dead = 0;
+    if (scenario.battle) {
+        BattleVisitor visitor;
+        // События идут в отчёт сценария: при --jobs отчёты печатаются
+        // целиком в порядке манифеста и не перемешиваются
+        if (!options.quiet) {
+            visitor.addObserver(std::make_shared<ConsoleObserver>(report));
+        }
+        for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+            deadBefore += editor.getStore().isAlive(i) ? 0 : 1;
+        }
+        BattleStats stats;
+        editor.startBattle(scenario.range, visitor, options.stats ? &stats : nullptr);
+        for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+            dead += editor.getStore().isAlive(i) ? 0 : 1;
+        }
+        if (options.stats) {
+            report << title << ":\n";
+            stats.print(report);
+        }
+    }
+
+    if (!scenario.save.empty() && !editor.saveToFile(scenario.save)) {
+        report << title << ": ошибка сохранения в " << scenario.save << "\n";
+        return false;
+    }
+
+    if (!options.quiet) {
+        report << title << ": NPC " << editor.getNPCCount();
+        if (scenario.battle) {
+            report << ", погибло " << dead - deadBefore;
+        }
+        if (!scenario.save.empty()) {
+            report << ", сохранено в " << scenario.save;
+        }
+        report << "\n";
+    }
+    return true;
+}
+
+}  // namespace
+
+bool BatchRunner::parseArguments(int argc, const char* const* argv, BatchOptions& options,
+                                 std::string& error) {
+    BatchScenario single;
+    bool hasSingle = false;
+
+    for (int k = 1; k < argc; ++k) {
+        std::string_view arg = argv[k];
+        // Ключи со значением
+        if (arg == "--load" || arg == "--battle" || arg == "--save" ||
+            arg == "--manifest" || arg == "--jobs") {
+            if (k + 1 >= argc) {
+                error = "нет значения для " + std::string(arg);
+                return false;
+            }
+            std::string_view value = argv[++k];
+            if (arg == "--load") {
+                single.load = value;
+                hasSingle = true;
+            } else if (arg == "--battle") {
+                if (!parseRange(value, single.range)) {
+                    error = "некорректный радиус боя: " + std::string(value);
+                    return false;
+                }
+                single.battle = true;
+                hasSingle = true;
+            } else if (arg == "--save") {
+                single.save = value;
+                hasSingle = true;
+            } else if (arg == "--manifest") {
+                if (!loadManifest(std::string(value), options.scenarios, error)) {
+                    return false;
+                }
+            } else {
+                if (!parseCount(value, options.jobs)) {
+                    error = "некорректное число заданий: " + std::string(value);
+                    return false;
+                }
+                // 0 — по числу ядер
+                if (options.jobs == 0) {
+                    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+                }
+            }
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else {
+            error = "неизвестный параметр: " + std::string(arg);
+            return false;
+        }
+    }
+
+    if (hasSingle) {
+        options.scenarios.insert(options.scenarios.begin(), single);
+    }
+    if (options.scenarios.empty()) {
+        error = "не задано ни одного сценария";
+        return false;
+    }
+    return true;
+}
+
+bool BatchRunner::loadManifest(const std::string& filename, std::vector<BatchScenario>& scenarios,
+                               std::string& error) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        error = "не удалось открыть манифест " + filename;
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        BatchScenario scenario;
+        if (!(fields >> scenario.load) || scenario.load[0] == '#') {
+            continue;
+        }
+        std::string range;
+        if (fields >> range && range != "-") {
+            if (!parseRange(range, scenario.range)) {
+                error = filename + ":" + std::to_string(lineNumber) + ": некорректный радиус боя";
+                return false;
+            }
+            scenario.battle = true;
+        }
+        fields >> scenario.save;
+        scenarios.push_back(std::move(scenario));
+    }
+    return true;
+}
+
+size_t BatchRunner::run(const BatchOptions& options, std::ostream& out, std::ostream& err) {
+    const std::vector<BatchScenario>& scenarios = options.scenarios;
+    std::vector<std::string> reports(scenarios.size());
+    std::vector<uint8_t> failed(scenarios.size(), 0);
+
+    // Сценарии независимы: у каждого свой редактор и свои наблюдатели
+    ThreadPool pool(std::max<size_t>(1, std::min(options.jobs, scenarios.size())));
+    pool.parallelFor(scenarios.size(), [&](size_t k) {
+        std::ostringstream report;
+        failed[k] = runScenario(scenarios[k], options, report) ? 0 : 1;
+        reports[k] = report.str();
+    });
+
+    size_t failures = 0;
+    for (size_t k = 0; k < scenarios.size(); ++k) {
+        (failed[k] ? err : out) << reports[k];
+        failures += failed[k];
+    }
+    return failures;
+}
+
+void BatchRunner::printUsage(std::ostream& out) {
+    out << "Использование:\n"
+        << "  editor                              интерактивное меню\n"
+        << "  editor [--load FILE] [--battle R] [--save FILE] [параметры]\n"
+        << "  editor --manifest FILE [параметры]  строки манифеста: LOAD [R|-] [SAVE]\n"
+        << "Параметры:\n"
+        << "  --quiet    не печатать события боя и итоги сценариев\n"
+        << "  --stats    печатать статистику боя\n"
+        << "  --jobs N   обрабатывать N сценариев одновременно (0 — по числу ядер)\n";
+}
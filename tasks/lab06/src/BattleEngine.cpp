@@ -0,0 +1,442 @@
+#include "BattleEngine.h"
+#include "BattleVisitor.h"
+#include "BattleSink.h"
+#include "BattleStats.h"
+#include "RangeKernel.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Замер фазы боя. Collect = false убирает вызовы часов при компиляции.
+template <bool Collect>
+class PhaseTimer {
+private:
+    Clock::time_point start;
+
+public:
+    PhaseTimer() {
+        if constexpr (Collect) {
+            start = Clock::now();
+        }
+    }
+
+    // Добавить прошедшее время к total и начать новый отсчёт
+    void lap(std::chrono::nanoseconds& total) {
+        if constexpr (Collect) {
+            Clock::time_point now = Clock::now();
+            total += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
+            start = now;
+        }
+    }
+};
+
+// Учёт исхода боя пары в статистике
+void countFight(BattleStats& stats, NPCType attacker, NPCType defender, BattleOutcome outcome) {
+    ++stats.fights;
+    if (outcome == BattleOutcome::MutualKill) {
+        ++stats.kills[static_cast<size_t>(defender)][static_cast<size_t>(attacker)];
+    }
+    ++stats.kills[static_cast<size_t>(attacker)][static_cast<size_t>(defender)];
+}
+
+// Противники NPC i: j > i в пределах дальности, с которыми бой возможен.
+// Результат упорядочен по возрастанию j.
+template <bool Collect>
+void collectTargets(const NPCStore& store, const SpatialGrid& grid, size_t i, double rangeSq,
+                    std::vector<size_t>& targets, std::vector<uint64_t>& mask, BattleStats& stats) {
+    const std::vector<double>& xs = store.xData();
+    const std::vector<double>& ys = store.yData();
+    const std::vector<NPCType>& types = store.typeData();
+    const BattleOutcome* outcomes = BATTLE_OUTCOMES[static_cast<size_t>(types[i])];
+
+    targets.clear();
+    grid.forEachNeighbourBlock(xs[i], ys[i],
+        [&](const size_t* indices, const double* bx, const double* by, size_t count) {
+            if constexpr (Collect) {
+                stats.rangeChecks += count;
+            }
+            mask.resize(rangeMaskWords(count));
+            rangeMask(xs[i], ys[i], bx, by, count, rangeSq, mask.data());
+            for (size_t w = 0; w < mask.size(); ++w) {
+                for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+                    size_t j = indices[w * 64 + __builtin_ctzll(bits)];
+                    // Пары, которые не могут подраться, отбрасываются до сортировки
+                    if (j > i && outcomes[static_cast<size_t>(types[j])] != BattleOutcome::None) {
+                        targets.push_back(j);
+                    }
+                }
+            }
+        });
+    std::sort(targets.begin(), targets.end());
+    if constexpr (Collect) {
+        stats.candidatePairs += targets.size();
+    }
+}
+
+// Пара (i, j) в одном ключе: сортировка ключей даёт порядок полного перебора
+uint64_t pairKey(size_t i, size_t j) {
+    return ((uint64_t)i << 32) | (uint64_t)j;
+}
+
+size_t keyAttacker(uint64_t key) {
+    return (size_t)(key >> 32);
+}
+
+size_t keyDefender(uint64_t key) {
+    return (size_t)(key & 0xffffffffu);
+}
+
+template <bool Collect, typename Sink>
+void resolveImpl(NPCStore& store, const MapBounds& bounds, double range,
+                 Sink sink, BattleStats& stats) {
+    // Отрицательный радиус (или NaN) не допускает ни одной пары
+    if (store.empty() || !(range >= 0)) {
+        return;
+    }
+    PhaseTimer<Collect> timer;
+
+    // Сетка с клеткой не меньше радиуса: пары ищутся только среди соседних клеток
+    SpatialGrid grid(bounds, range);
+    grid.build(store.xData(), store.yData());
+    timer.lap(stats.gridTime);
+
+    // Пары (i, j), i < j, обрабатываются в том же порядке, что и при полном переборе.
+    // Дальность проверяется пакетно по квадрату расстояния для целого блока клеток.
+    const std::vector<NPCType>& types = store.typeData();
+    const double rangeSq = range * range;
+    std::vector<uint64_t> mask;
+    BattleEngine::fightInOrder(store,
+        [&](size_t i, std::vector<size_t>& targets) {
+            timer.lap(stats.fightTime);
+            collectTargets<Collect>(store, grid, i, rangeSq, targets, mask, stats);
+            timer.lap(stats.searchTime);
+        },
+        [&](size_t i, size_t j, BattleOutcome outcome) {
+            if constexpr (Collect) {
+                countFight(stats, types[i], types[j], outcome);
+            }
+            sink.onFight(store, i, j, outcome);
+        });
+    timer.lap(stats.fightTime);
+}
+
+template <bool Collect, typename Sink>
+void resolveIndexedImpl(NPCStore& store, const MapBounds& bounds, double range,
+                        Sink sink, BattleStats& stats) {
+    if (store.empty() || !(range >= 0)) {
+        return;
+    }
+    PhaseTimer<Collect> timer;
+
+    // Индекс строится при первом вызове, дальше его обновляет хранилище
+    const DynamicGrid& grid = store.spatialIndex(bounds, range);
+    timer.lap(stats.gridTime);
+
+    const std::vector<NPCType>& types = store.typeData();
+    RangeScratch scratch;
+    BattleEngine::fightInOrder(store,
+        [&](size_t i, std::vector<size_t>& targets) {
+            const BattleOutcome* outcomes = BATTLE_OUTCOMES[static_cast<size_t>(types[i])];
+            targets.clear();
+            // Погибшие остаются в индексе до removeDead и отбрасываются здесь
+            size_t checked = grid.forEachWithin(store.xData().data(), store.yData().data(),
+                                                store.x(i), store.y(i), range, scratch, [&](size_t j) {
+                if (j > i && store.isAlive(j) && outcomes[static_cast<size_t>(types[j])] != BattleOutcome::None) {
+                    targets.push_back(j);
+                }
+            });
+            std::sort(targets.begin(), targets.end());
+            if constexpr (Collect) {
+                stats.rangeChecks += checked;
+                stats.candidatePairs += targets.size();
+            }
+        },
+        [&](size_t i, size_t j, BattleOutcome outcome) {
+            if constexpr (Collect) {
+                countFight(stats, types[i], types[j], outcome);
+            }
+            sink.onFight(store, i, j, outcome);
+        });
+    // Поиск и бои чередуются по нападающим: время идёт в fightTime целиком
+    timer.lap(stats.fightTime);
+}
+
+template <bool Collect, typename Sink>
+void resolveDirtyImpl(NPCStore& store, const MapBounds& bounds, double range,
+                      size_t firstDirty, Sink sink, BattleStats& stats) {
+    if (firstDirty >= store.size() || !(range >= 0)) {
+        return;
+    }
+    PhaseTimer<Collect> timer;
+
+    // Индекс хранилища обновляется вместе с ним: сетка строится один раз,
+    // а не заново на каждый повторный бой
+    const DynamicGrid& grid = store.spatialIndex(bounds, range);
+    timer.lap(stats.gridTime);
+
+    const std::vector<NPCType>& types = store.typeData();
+
+    // Для нового NPC j собираются все i < j в пределах дальности:
+    // так находятся и пары со старыми NPC, и пары новых между собой
+    std::vector<uint64_t> pairs;
+    RangeScratch scratch;
+    for (size_t j = firstDirty; j < store.size(); ++j) {
+        if (!store.isAlive(j)) {
+            continue;
+        }
+        size_t checked = grid.forEachWithin(store.xData().data(), store.yData().data(),
+                                            store.x(j), store.y(j), range, scratch, [&](size_t i) {
+            if (i < j && store.isAlive(i) && battleOutcome(types[i], types[j]) != BattleOutcome::None) {
+                pairs.push_back(pairKey(i, j));
+            }
+        });
+        if constexpr (Collect) {
+            stats.rangeChecks += checked;
+        }
+    }
+
+    // Тот же порядок (i, j), что и при полном проходе
+    std::sort(pairs.begin(), pairs.end());
+    if constexpr (Collect) {
+        stats.candidatePairs += pairs.size();
+    }
+    timer.lap(stats.searchTime);
+
+    for (uint64_t key : pairs) {
+        size_t i = keyAttacker(key);
+        size_t j = keyDefender(key);
+        BattleOutcome outcome = battleOutcome(types[i], types[j]);
+        if (store.applyOutcome(i, j, outcome)) {
+            if constexpr (Collect) {
+                countFight(stats, types[i], types[j], outcome);
+            }
+            sink.onFight(store, i, j, outcome);
+        }
+    }
+    timer.lap(stats.fightTime);
+}
+
+template <bool Collect, typename Sink>
+void resolveSimultaneousImpl(NPCStore& store, const MapBounds& bounds, double range,
+                             Sink sink, ThreadPool* pool, BattleStats& stats) {
+    if (store.empty() || !(range >= 0)) {
+        return;
+    }
+    PhaseTimer<Collect> timer;
+
+    SpatialGrid grid(bounds, range);
+    grid.build(store.xData(), store.yData());
+    // Замороженные флаги жизни: по ним решается, кто сражается в этом бою
+    const std::vector<uint8_t> aliveAtStart = store.aliveData();
+    timer.lap(stats.gridTime);
+
+    const std::vector<NPCType>& types = store.typeData();
+    const double rangeSq = range * range;
+
+    // 1. Нападающие делятся на отрезки индексов; отрезки независимы, потому что
+    //    хранилище не меняется до конца прохода. Убитые отмечаются в общей
+    //    битовой маске, бои (для событий) копятся по отрезкам в порядке (i, j).
+    constexpr bool Report = Sink::ENABLED || Collect;
+    const size_t words = (store.size() + 63) / 64;
+    std::unique_ptr<std::atomic<uint64_t>[]> killed(new std::atomic<uint64_t>[words]);
+    for (size_t w = 0; w < words; ++w) {
+        killed[w].store(0, std::memory_order_relaxed);
+    }
+    // Большинство NPC убивают по многу раз: запись только при первой отметке
+    auto markKilled = [&](size_t v) {
+        const uint64_t bit = uint64_t(1) << (v % 64);
+        std::atomic<uint64_t>& word = killed[v / 64];
+        if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+            word.fetch_or(bit, std::memory_order_relaxed);
+        }
+    };
+    const size_t chunk = 4096;
+    const size_t chunks = (store.size() + chunk - 1) / chunk;
+    std::vector<std::vector<uint64_t>> chunkFights(Report ? chunks : 0);
+    std::vector<BattleStats> chunkStats(Collect ? chunks : 0);
+    const std::vector<double>& xs = store.xData();
+    const std::vector<double>& ys = store.yData();
+    auto scan = [&](size_t c) {
+        std::vector<uint64_t> mask;
+        BattleStats local;
+        const size_t end = std::min(store.size(), (c + 1) * chunk);
+        for (size_t i = c * chunk; i < end; ++i) {
+            if (!canAttack(types[i]) || !aliveAtStart[i]) {
+                continue;
+            }
+            // Исход пары не зависит от других пар, поэтому убитые отмечаются
+            // прямо по маске дальности; сортировка нужна только событиям
+            const BattleOutcome* outcomes = BATTLE_OUTCOMES[static_cast<size_t>(types[i])];
+            const size_t firstFight = Report ? chunkFights[c].size() : 0;
+            grid.forEachNeighbourBlock(xs[i], ys[i],
+                [&](const size_t* indices, const double* bx, const double* by, size_t count) {
+                    if constexpr (Collect) {
+                        local.rangeChecks += count;
+                    }
+                    mask.resize(rangeMaskWords(count));
+                    rangeMask(xs[i], ys[i], bx, by, count, rangeSq, mask.data());
+                    for (size_t w = 0; w < mask.size(); ++w) {
+                        for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+                            size_t j = indices[w * 64 + __builtin_ctzll(bits)];
+                            BattleOutcome outcome = outcomes[static_cast<size_t>(types[j])];
+                            if (j <= i || outcome == BattleOutcome::None) {
+                                continue;
+                            }
+                            // Погибших до боя не считают и другие проходы
+                            if (!aliveAtStart[j]) {
+                                continue;
+                            }
+                            if constexpr (Collect) {
+                                ++local.candidatePairs;
+                            }
+                            if (outcome == BattleOutcome::MutualKill) {
+                                markKilled(i);
+                            }
+                            markKilled(j);
+                            if constexpr (Report) {
+                                chunkFights[c].push_back(pairKey(i, j));
+                            }
+                        }
+                    }
+                });
+            if constexpr (Report) {
+                std::sort(chunkFights[c].begin() + firstFight, chunkFights[c].end());
+            }
+        }
+        if constexpr (Collect) {
+            chunkStats[c] = local;
+        }
+    };
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(chunks, scan);
+    } else {
+        for (size_t c = 0; c < chunks; ++c) {
+            scan(c);
+        }
+    }
+    if constexpr (Collect) {
+        for (const BattleStats& local : chunkStats) {
+            stats.rangeChecks += local.rangeChecks;
+            stats.candidatePairs += local.candidatePairs;
+        }
+    }
+    timer.lap(stats.searchTime);
+
+    // 2. Слияние: флаги жизни снимаются по маске в порядке индексов
+    //    (из одного потока, так что журнал видит всех убитых)
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t bits = killed[w].load(std::memory_order_relaxed); bits != 0; bits &= bits - 1) {
+            store.kill(w * 64 + __builtin_ctzll(bits));
+        }
+    }
+
+    // 3. События — в порядке (i, j); отрезки уже идут по возрастанию i
+    if constexpr (Report) {
+        for (const auto& fights : chunkFights) {
+            for (uint64_t key : fights) {
+                size_t i = keyAttacker(key);
+                size_t j = keyDefender(key);
+                BattleOutcome outcome = battleOutcome(types[i], types[j]);
+                if constexpr (Collect) {
+                    countFight(stats, types[i], types[j], outcome);
+                }
+                sink.onFight(store, i, j, outcome);
+            }
+        }
+    }
+    timer.lap(stats.fightTime);
+}
+
+// Без статистики вызывается вариант, собранный без счётчиков и замеров
+template <typename Sink>
+void resolveWith(NPCStore& store, const MapBounds& bounds, double range, Sink sink,
+                 BattleStats* stats) {
+    if (stats) {
+        resolveImpl<true>(store, bounds, range, sink, *stats);
+    } else {
+        BattleStats unused;
+        resolveImpl<false>(store, bounds, range, sink, unused);
+    }
+}
+
+template <typename Sink>
+void resolveIndexedWith(NPCStore& store, const MapBounds& bounds, double range, Sink sink,
+                        BattleStats* stats) {
+    if (stats) {
+        resolveIndexedImpl<true>(store, bounds, range, sink, *stats);
+    } else {
+        BattleStats unused;
+        resolveIndexedImpl<false>(store, bounds, range, sink, unused);
+    }
+}
+
+template <typename Sink>
+void resolveDirtyWith(NPCStore& store, const MapBounds& bounds, double range, size_t firstDirty,
+                      Sink sink, BattleStats* stats) {
+    if (stats) {
+        resolveDirtyImpl<true>(store, bounds, range, firstDirty, sink, *stats);
+    } else {
+        BattleStats unused;
+        resolveDirtyImpl<false>(store, bounds, range, firstDirty, sink, unused);
+    }
+}
+
+template <typename Sink>
+void resolveSimultaneousWith(NPCStore& store, const MapBounds& bounds, double range, Sink sink,
+                             ThreadPool* pool, BattleStats* stats) {
+    if (stats) {
+        resolveSimultaneousImpl<true>(store, bounds, range, sink, pool, *stats);
+    } else {
+        BattleStats unused;
+        resolveSimultaneousImpl<false>(store, bounds, range, sink, pool, unused);
+    }
+}
+
+}  // namespace
+
+void BattleEngine::resolve(NPCStore& store, const MapBounds& bounds, double range,
+                           BattleVisitor& visitor, BattleStats* stats) {
+    resolveWith(store, bounds, range, VisitorSink(visitor), stats);
+}
+
+void BattleEngine::resolve(NPCStore& store, const MapBounds& bounds, double range,
+                           NullSink sink, BattleStats* stats) {
+    resolveWith(store, bounds, range, sink, stats);
+}
+
+void BattleEngine::resolveIndexed(NPCStore& store, const MapBounds& bounds, double range,
+                                  BattleVisitor& visitor, BattleStats* stats) {
+    resolveIndexedWith(store, bounds, range, VisitorSink(visitor), stats);
+}
+
+void BattleEngine::resolveIndexed(NPCStore& store, const MapBounds& bounds, double range,
+                                  NullSink sink, BattleStats* stats) {
+    resolveIndexedWith(store, bounds, range, sink, stats);
+}
+
+void BattleEngine::resolveDirty(NPCStore& store, const MapBounds& bounds, double range,
+                                size_t firstDirty, BattleVisitor& visitor, BattleStats* stats) {
+    resolveDirtyWith(store, bounds, range, firstDirty, VisitorSink(visitor), stats);
+}
+
+void BattleEngine::resolveDirty(NPCStore& store, const MapBounds& bounds, double range,
+                                size_t firstDirty, NullSink sink, BattleStats* stats) {
+    resolveDirtyWith(store, bounds, range, firstDirty, sink, stats);
+}
+
+void BattleEngine::resolveSimultaneous(NPCStore& store, const MapBounds& bounds, double range,
+                                       BattleVisitor& visitor, ThreadPool* pool, BattleStats* stats) {
+    resolveSimultaneousWith(store, bounds, range, VisitorSink(visitor), pool, stats);
+}
+
+void BattleEngine::resolveSimultaneous(NPCStore& store, const MapBounds& bounds, double range,
+                                       NullSink sink, ThreadPool* pool, BattleStats* stats) {
+    resolveSimultaneousWith(store, bounds, range, sink, pool, stats);
+}
@@ -0,0 +1,42 @@
+#include "BattleStats.h"
+#include "NPCTypes.h"
+#include <ostream>
+
+namespace {
+
+double toMilliseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+}  // namespace
+
+uint64_t BattleStats::totalKills() const {
+    uint64_t total = 0;
+    for (const auto& row : kills) {
+        for (uint64_t count : row) {
+            total += count;
+        }
+    }
+    return total;
+}
+
+void BattleStats::print(std::ostream& out) const {
+    out << "=== Статистика боя ===\n";
+    out << "Проверено расстояний: " << rangeChecks << "\n";
+    out << "Пар в пределах дальности: " << candidatePairs << "\n";
+    out << "Боёв: " << fights << "\n";
+    out << "Погибших: " << totalKills() << "\n";
+    for (size_t killer = 0; killer < NPC_TYPE_COUNT; ++killer) {
+        for (size_t victim = 0; victim < NPC_TYPE_COUNT; ++victim) {
+            if (kills[killer][victim] != 0) {
+                out << "  " << npcTypeName(static_cast<NPCType>(killer)) << " -> "
+                    << npcTypeName(static_cast<NPCType>(victim)) << ": "
+                    << kills[killer][victim] << "\n";
+            }
+        }
+    }
+    out << "Время, мс: сетка " << toMilliseconds(gridTime)
+        << ", поиск пар " << toMilliseconds(searchTime)
+        << ", бои " << toMilliseconds(fightTime)
+        << ", доставка " << toMilliseconds(deliveryTime) << "\n";
+}
@@ -1,60 +1,117 @@
 #include "BattleVisitor.h"
-#include "Dragon.h"
-#include "Bull.h"
-#include "Frog.h"
+#include "NPC.h"
 #include "Observer.h"
+#include "NPCStore.h"
+#include "KillEventPipeline.h"
+
+BattleVisitor::BattleVisitor() = default;
+
+BattleVisitor::~BattleVisitor() = default;
 
 void BattleVisitor::addObserver(std::shared_ptr<BattleObserver> observer) {
+    // Поток доставки не должен читать список во время изменения
+    drain();
     observers.push_back(observer);
 }
 
-void BattleVisitor::notifyKill(const std::string& killer, const std::string& victim) {
-    for (auto& observer : observers) {
-        observer->onKill(killer, victim);
+void BattleVisitor::enableAsync(size_t capacity, Backpressure policy) {
+    disableAsync();
+    pipeline = std::make_unique<KillEventPipeline>(capacity, policy, [this](const KillEvent& event) {
+        dispatchKill(event);
+    });
+}
+
+void BattleVisitor::disableAsync() {
+    // Деструктор доставляет оставшиеся события и останавливает поток
+    pipeline.reset();
+}
+
+void BattleVisitor::drain() {
+    if (pipeline) {
+        pipeline->drain();
     }
 }
 
-void BattleVisitor::visit(Dragon& dragon, Bull& bull) {
-    if (dragon.isAlive() && bull.isAlive()) {
-        bull.kill();
-        notifyKill(dragon.getName(), bull.getName());
+size_t BattleVisitor::droppedEvents() const {
+    return pipeline ? pipeline->droppedCount() : 0;
+}
+
+void BattleVisitor::dispatchKill(const KillEvent& event) {
+    for (auto& observer : observers) {
+        observer->onKill(event);
     }
 }
 
-void BattleVisitor::visit(Bull& bull, Frog& frog) {
-    if (bull.isAlive() && frog.isAlive()) {
-        frog.kill();
-        notifyKill(bull.getName(), frog.getName());
+void BattleVisitor::notifyKill(const KillEvent& event) {
+    if (pipeline) {
+        pipeline->push(event);
+    } else {
+        dispatchKill(event);
     }
 }
 
-void BattleVisitor::visit(Dragon& dragon, Frog& frog) {
+NameId BattleVisitor::localName(std::string_view name) {
+    // Поток доставки может читать уже записанные имена: новое имя их не трогает,
+    // поэтому очередь не нужно доставлять заранее
+    NameId id;
+    if (!localNames.find(name, id)) {
+        id = localNames.intern(name);
+    }
+    return id;
 }
 
-void BattleVisitor::visit(Bull& bull, Dragon& dragon) {
+void BattleVisitor::notifyBattleEnd() {
+    drain();
+    for (auto& observer : observers) {
+        observer->onBattleEnd();
+    }
+    localNames.clear();
 }
 
-void BattleVisitor::visit(Frog& frog, Bull& bull) {
+void BattleVisitor::fight(NPC& attacker, NPC& defender, BattleOutcome outcome) {
+    if (!attacker.isAlive() || !defender.isAlive()) {
+        return;
+    }
+    switch (outcome) {
+        case BattleOutcome::AttackerKills:
+            defender.kill();
+            break;
+        case BattleOutcome::MutualKill:
+            attacker.kill();
+            defender.kill();
+            break;
+        case BattleOutcome::None:
+            return;
+    }
+    notifyKill(KillEvent{&localNames, localName(attacker.getName()), localName(defender.getName()),
+                         outcome == BattleOutcome::MutualKill});
 }
 
-void BattleVisitor::visit(Frog& frog, Dragon& dragon) {
+void BattleVisitor::fight(NPC& attacker, NPC& defender) {
+    fight(attacker, defender, battleOutcome(attacker.getTypeTag(), defender.getTypeTag()));
 }
 
-void BattleVisitor::visit(Dragon& d1, Dragon& d2) {
-    if (d1.isAlive() && d2.isAlive()) {
-        d1.kill();
-        d2.kill();
-        notifyKill(d1.getName() + " и " + d2.getName(), "друг друга");
+void BattleVisitor::fight(NPCStore& store, size_t attacker, size_t defender, BattleOutcome outcome) {
+    if (store.applyOutcome(attacker, defender, outcome)) {
+        notifyFight(store, attacker, defender, outcome);
     }
 }
 
-void BattleVisitor::visit(Bull& b1, Bull& b2) {
-    if (b1.isAlive() && b2.isAlive()) {
-        b1.kill();
-        b2.kill();
-        notifyKill(b1.getName() + " и " + b2.getName(), "друг друга");
+void BattleVisitor::notifyFight(const NPCStore& store, size_t attacker, size_t defender, BattleOutcome outcome) {
+    if (outcome == BattleOutcome::None) {
+        return;
     }
+    // Только номера имён: текст получат наблюдатели, которые его печатают
+    notifyKill(KillEvent{&store.nameTable(), store.nameId(attacker), store.nameId(defender),
+                         outcome == BattleOutcome::MutualKill});
 }
 
-void BattleVisitor::visit(Frog& f1, Frog& f2) {
+void BattleVisitor::notifyFight(const NPCStore& attackerStore, size_t attacker,
+                                const NPCStore& defenderStore, size_t defender, BattleOutcome outcome) {
+    if (outcome == BattleOutcome::None) {
+        return;
+    }
+    NameId killer = localName(attackerStore.name(attacker));
+    NameId victim = localName(defenderStore.name(defender));
+    notifyKill(KillEvent{&localNames, killer, victim, outcome == BattleOutcome::MutualKill});
 }
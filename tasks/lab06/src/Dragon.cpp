@@ -1,17 +1,4 @@
 #include "Dragon.h"
-#include "Bull.h"
-#include "Frog.h"
-#include "BattleVisitor.h"
 
-Dragon::Dragon(const std::string& name, double x, double y) 
-    : NPC(name, x, y) {}
-
-void Dragon::accept(BattleVisitor& visitor, NPC& other) {
-    if (Dragon* d = dynamic_cast<Dragon*>(&other)) {
-        visitor.visit(*this, *d);
-    } else if (Bull* b = dynamic_cast<Bull*>(&other)) {
-        visitor.visit(*this, *b);
-    } else if (Frog* f = dynamic_cast<Frog*>(&other)) {
-        visitor.visit(*this, *f);
-    }
-}
+Dragon::Dragon(std::string_view name, double x, double y) 
+    : NPC(name, x, y, TAG) {}
@@ -0,0 +1,103 @@
+#include "DynamicGrid.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicGrid::DynamicGrid(const MapBounds& bounds, double range)
+    : minX(bounds.minX), minY(bounds.minY) {
+    double span = std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY);
+    cellSize = std::max(range, span / MAX_CELLS_PER_AXIS);
+    if (!(cellSize > 0)) {
+        cellSize = 1.0;
+    }
+    width = std::max<size_t>(1, (size_t)std::ceil((bounds.maxX - bounds.minX) / cellSize));
+    height = std::max<size_t>(1, (size_t)std::ceil((bounds.maxY - bounds.minY) / cellSize));
+    width = std::min(width, MAX_CELLS_PER_AXIS);
+    height = std::min(height, MAX_CELLS_PER_AXIS);
+    head.assign(width * height, NONE);
+    parkedHead.assign(width * height, NONE);
+}
+
+size_t DynamicGrid::cellCoord(double value, double origin, size_t cells) const {
+    // Точки за пределами карты прижимаются к крайним клеткам
+    double c = std::floor((value - origin) / cellSize);
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= (double)(cells - 1)) {
+        return cells - 1;
+    }
+    return (size_t)c;
+}
+
+void DynamicGrid::reset(size_t count) {
+    std::fill(head.begin(), head.end(), NONE);
+    std::fill(parkedHead.begin(), parkedHead.end(), NONE);
+    next.assign(count, NONE);
+    prev.assign(count, NONE);
+    cellOf.assign(count, NONE);
+    parked.assign(count, 0);
+}
+
+void DynamicGrid::link(uint32_t i, size_t cell, bool toParked) {
+    uint32_t& first = toParked ? parkedHead[cell] : head[cell];
+    cellOf[i] = (uint32_t)cell;
+    parked[i] = toParked ? 1 : 0;
+    prev[i] = NONE;
+    next[i] = first;
+    if (first != NONE) {
+        prev[first] = i;
+    }
+    first = i;
+}
+
+void DynamicGrid::unlink(uint32_t i) {
+    if (prev[i] != NONE) {
+        next[prev[i]] = next[i];
+    } else if (parked[i]) {
+        parkedHead[cellOf[i]] = next[i];
+    } else {
+        head[cellOf[i]] = next[i];
+    }
+    if (next[i] != NONE) {
+        prev[next[i]] = prev[i];
+    }
+    cellOf[i] = NONE;
+}
+
+void DynamicGrid::insert(size_t i, double x, double y) {
+    if (i >= cellOf.size()) {
+        next.resize(i + 1, NONE);
+        prev.resize(i + 1, NONE);
+        cellOf.resize(i + 1, NONE);
+        parked.resize(i + 1, 0);
+    }
+    if (cellOf[i] != NONE) {
+        unlink((uint32_t)i);
+    }
+    link((uint32_t)i, cellIndex(x, y), false);
+}
+
+void DynamicGrid::remove(size_t i) {
+    if (contains(i)) {
+        unlink((uint32_t)i);
+    }
+}
+
+void DynamicGrid::park(size_t i) {
+    if (!contains(i) || parked[i]) {
+        return;
+    }
+    size_t cell = cellOf[i];
+    unlink((uint32_t)i);
+    link((uint32_t)i, cell, true);
+}
+
+void DynamicGrid::move(size_t i, double x, double y) {
+    size_t cell = cellIndex(x, y);
+    if (!contains(i) || cellOf[i] == cell) {
+        return;
+    }
+    bool wasParked = parked[i] != 0;
+    unlink((uint32_t)i);
+    link((uint32_t)i, cell, wasParked);
+}
@@ -1,13 +1,27 @@
 #include "Editor.h"
+#include "NPCTypes.h"
 #include "NPCFactory.h"
+#include "BattleEngine.h"
+#include "BattleStats.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+#include "WorldSnapshot.h"
+#include "Journal.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
-bool Editor::addNPC(std::shared_ptr<NPC> npc) {
+Editor::Editor() = default;
+
+Editor::~Editor() {
+    closeJournal();
+}
+
+bool Editor::addNPC(std::shared_ptr<NPC> npc, NPCHandle* handle) {
     // Проверка координат
-    if (npc->getX() < 0 || npc->getX() > 500 || 
-        npc->getY() < 0 || npc->getY() > 500) {
+    if (!isOnMap(npc->getX(), npc->getY())) {
         return false;
     }
     
@@ -16,99 +30,390 @@ bool Editor::addNPC(std::shared_ptr<NPC> npc) {
         return false;
     }
     
-    npcs.push_back(npc);
+    size_t index = store.add(npc);
+    if (journal) {
+        journal->add(npc->getTypeTag(), npc->getName(), npc->getX(), npc->getY());
+        journalKills();
+    }
+    if (handle) {
+        *handle = store.handle(index);
+    }
     return true;
 }
 
-bool Editor::isNameUnique(const std::string& name) const {
-    for (const auto& npc : npcs) {
-        if (npc->getName() == name) {
-            return false;
+BulkAddResult Editor::addNPCs(const NPCSpec* specs, size_t count) {
+    BulkAddResult result;
+    result.added.assign((count + 63) / 64, 0);
+    // Массивы растут вдвое и только при нехватке места, чтобы серия
+    // небольших пакетов не перевыделяла их на каждом вызове
+    if (store.size() + count > store.capacity()) {
+        store.reserve(std::max(store.size() + count, 2 * store.capacity()));
+    }
+    for (size_t k = 0; k < count; ++k) {
+        const NPCSpec& spec = specs[k];
+        if (!isOnMap(spec.x, spec.y)) {
+            continue;
+        }
+        // Проверка имени и его добавление в таблицу — один поиск; имена
+        // из этого же пакета к этому моменту уже в таблице
+        if (store.addUnique(spec.type, spec.name, spec.x, spec.y) == NPCStore::npos) {
+            continue;
+        }
+        if (journal) {
+            journal->add(spec.type, spec.name, spec.x, spec.y);
         }
+        result.added[k / 64] |= uint64_t(1) << (k % 64);
+        ++result.addedCount;
     }
-    return true;
+    if (journal) {
+        journalKills();
+    }
+    return result;
+}
+
+bool Editor::isNameUnique(std::string_view name) const {
+    return !store.containsName(name);
 }
 
-bool Editor::saveToFile(const std::string& filename) const {
+bool Editor::saveToFile(const std::string& filename, SaveFormat format) const {
+    if (format == SaveFormat::Auto) {
+        bool binary = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0;
+        format = binary ? SaveFormat::Binary : SaveFormat::Text;
+    }
+    if (format == SaveFormat::Binary) {
+        return WorldSnapshot::save(store, filename);
+    }
+    
     std::ofstream file(filename);
     if (!file.is_open()) {
         return false;
     }
     
-    for (const auto& npc : npcs) {
-        if (npc->isAlive()) {
-            file << npc->getType() << " " 
-                 << npc->getName() << " " 
-                 << npc->getX() << " " 
-                 << npc->getY() << std::endl;
+    // '\n' вместо std::endl: поток сбрасывается один раз при закрытии
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.isAlive(i)) {
+            file << npcTypeName(store.type(i)) << " " 
+                 << store.name(i) << " " 
+                 << store.x(i) << " " 
+                 << store.y(i) << '\n';
         }
     }
     
     file.close();
-    return true;
+    return (bool)file;
 }
 
-bool Editor::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+bool Editor::loadFromFile(const std::string& filename, std::vector<LoadError>* errors) {
+    MappedFile file;
+    if (!file.open(filename)) {
         return false;
     }
     
-    npcs.clear();
-    std::string line;
+    std::string_view text = file.view();
     
-    while (std::getline(file, line)) {
-        auto npc = NPCFactory::loadFromString(line);
-        if (npc) {
-            npcs.push_back(npc);
+    if (WorldSnapshot::isSnapshot(text)) {
+        std::string error;
+        size_t record = 0;
+        if (!WorldSnapshot::load(text, store, &error, &record)) {
+            if (errors) {
+                errors->push_back({record, error});
+            }
+            return false;
+        }
+        pool.clear();
+        checkedCount = 0;
+        killed.clear();
+        if (journal) {
+            journal->compact(store);
         }
+        return true;
     }
     
-    file.close();
+    clear();
+    
+    // Место под все строки выделяется один раз
+    store.reserve((size_t)std::count(text.begin(), text.end(), '\n') + 1);
+    
+    // Строки разбираются прямо в отображённой памяти, без объектов NPC
+    size_t lineNumber = 0;
+    while (!text.empty()) {
+        ++lineNumber;
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+        
+        // Пустые строки не считаются ошибкой
+        if (line.find_first_not_of(" \t\v\f\r") == std::string_view::npos) {
+            continue;
+        }
+        
+        NPCRecord record;
+        const char* error = nullptr;
+        if (!NPCFactory::parseRecord(line, record, &error)) {
+            if (errors) {
+                errors->push_back({lineNumber, error});
+            }
+        } else if (store.containsName(record.name)) {
+            if (errors) {
+                errors->push_back({lineNumber, "имя уже занято"});
+            }
+        } else {
+            store.add(record.type, record.name, record.x, record.y);
+        }
+    }
+    
+    // Загруженный мир сразу становится новым снимком журнала
+    if (journal) {
+        journal->compact(store);
+    }
+    return true;
+}
+
+bool Editor::openJournal(const std::string& path, const JournalOptions& options, std::string* error) {
+    closeJournal();
+    auto opened = std::make_unique<Journal>(path, options);
+    // При ошибке хранилище не тронуто
+    if (!opened->open(store, error)) {
+        return false;
+    }
+    pool.clear();
+    checkedCount = 0;
+    journal = std::move(opened);
+    store.setKillLog(&killed);
     return true;
 }
 
+bool Editor::openJournal(const std::string& path, std::string* error) {
+    return openJournal(path, JournalOptions(), error);
+}
+
+bool Editor::syncJournal() {
+    if (!journal) {
+        return false;
+    }
+    journalKills();
+    return journal->commit();
+}
+
+bool Editor::compactJournal() {
+    if (!journal) {
+        return false;
+    }
+    // Снимок уже содержит все убийства
+    killed.clear();
+    return journal->compact(store);
+}
+
+void Editor::closeJournal() {
+    if (journal) {
+        syncJournal();
+        journal.reset();
+    }
+    store.setKillLog(nullptr);
+    killed.clear();
+}
+
+void Editor::journalKills() {
+    for (uint32_t i : killed) {
+        journal->kill(store.name(i));
+    }
+    killed.clear();
+    if (journal->needsCompaction()) {
+        journal->compact(store);
+    }
+}
+
 void Editor::printAll() const {
-    if (npcs.empty()) {
+    if (store.empty()) {
         std::cout << "В подземелье нет NPC." << std::endl;
         return;
     }
     std::cout << "\n=== NPC в подземелье ===" << std::endl;
-    for (const auto& npc : npcs) {
-        if (npc->isAlive()) {
-            std::cout << npc->toString() << std::endl;
+    size_t aliveCount = 0;
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.isAlive(i)) {
+            std::cout << NPC::format(store.type(i), store.name(i), store.x(i), store.y(i)) << std::endl;
+            ++aliveCount;
         }
     }
-    std::cout << "Всего живых: " << 
-        std::count_if(npcs.begin(), npcs.end(), 
-                     [](const auto& n) { return n->isAlive(); }) << std::endl;
+    std::cout << "Всего живых: " << aliveCount << std::endl;
 }
 
-void Editor::startBattle(double range, BattleVisitor& visitor) {
-    // Проход по всем парам NPC
-    for (size_t i = 0; i < npcs.size(); ++i) {
-        for (size_t j = i + 1; j < npcs.size(); ++j) {
-            if (npcs[i]->isAlive() && npcs[j]->isAlive()) {
-                // Проверка дистанции
-                if (npcs[i]->distanceTo(*npcs[j]) <= range) {
-                    npcs[i]->accept(visitor, *npcs[j]);
-                }
-            }
+void Editor::startBattle(double range, BattleVisitor& visitor, BattleStats* stats) {
+    if (stats) {
+        *stats = BattleStats();
+    }
+    resolveBattle(range, visitor, stats);
+    
+    // К возврату все события доставлены, а буферы наблюдателей сброшены.
+    // Часы читаются, только если нужна статистика.
+    std::chrono::steady_clock::time_point deliveryStart;
+    if (stats) {
+        deliveryStart = std::chrono::steady_clock::now();
+    }
+    visitor.drain();
+    visitor.notifyBattleEnd();
+    if (stats) {
+        stats->deliveryTime = std::chrono::steady_clock::now() - deliveryStart;
+    }
+}
+
+void Editor::resolveBattle(double range, BattleVisitor& visitor, BattleStats* stats) {
+    // Отрицательный радиус (или NaN) не допускает ни одной пары
+    if (!(range >= 0)) {
+        return;
+    }
+    const MapBounds bounds{0, 0, MAP_SIZE, MAP_SIZE};
+    // Без наблюдателей проход собирается с NullSink: события не строятся
+    auto run = [&](auto&& sink) {
+        if (battleMode == BattleMode::Simultaneous) {
+            // Убитые снимаются в конце из одного потока, так что журнал их видит.
+            // Повторный бой тоже идёт полным проходом.
+            BattleEngine::resolveSimultaneous(store, bounds, range, sink, threads.get(), stats);
+        } else if (checkedCount > 0 && range <= checkedRange) {
+            BattleEngine::resolveDirty(store, bounds, range, checkedCount, sink, stats);
+        } else {
+            BattleEngine::resolve(store, bounds, range, sink, stats);
         }
+    };
+    if (visitor.hasObservers()) {
+        run(visitor);
+    } else {
+        run(NullSink());
+    }
+    // Теперь все NPC прошли бой с радиусом range
+    checkedCount = store.size();
+    checkedRange = range;
+    if (journal) {
+        journalKills();
+    }
+}
+
+void Editor::resolveMoving(double range, BattleVisitor& visitor, BattleStats* stats) {
+    // Индекс общий с пространственными запросами; если его ещё нет, клетка равна радиусу
+    const MapBounds bounds{0, 0, MAP_SIZE, MAP_SIZE};
+    if (visitor.hasObservers()) {
+        BattleEngine::resolveIndexed(store, bounds, range, visitor, stats);
+    } else {
+        BattleEngine::resolveIndexed(store, bounds, range, NullSink(), stats);
     }
 }
 
+void Editor::setThreadCount(size_t count) {
+    if (count <= 1) {
+        threads.reset();
+    } else if (!threads || threads->size() != count) {
+        threads = std::make_unique<ThreadPool>(count);
+    }
+}
+
+size_t Editor::getThreadCount() const {
+    return threads ? threads->size() : 1;
+}
+
 void Editor::removeDeadNPCs() {
-    npcs.erase(
-        std::remove_if(npcs.begin(), npcs.end(),
-                      [](const auto& npc) { return !npc->isAlive(); }),
-        npcs.end()
-    );
+    // Индексы убитых после удаления станут другими: сначала они пишутся в журнал
+    if (journal) {
+        journalKills();
+        journal->removeDead();
+    }
+    // Проверенные NPC остаются в начале
+    checkedCount = store.removeDead(checkedCount);
+}
+
+void Editor::clear() {
+    if (journal) {
+        killed.clear();
+        journal->clear();
+    }
+    store.clear();
+    pool.clear();
+    checkedCount = 0;
+}
+
+std::shared_ptr<NPC> Editor::createNPC(NPCType type, std::string_view name, double x, double y) {
+    return NPCFactory::createNPC(type, name, x, y, pool);
 }
 
 std::shared_ptr<NPC> Editor::getNPC(size_t index) const {
-    if (index < npcs.size()) {
-        return npcs[index];
+    if (index < store.size()) {
+        return store.view(index, pool);
+    }
+    return nullptr;
+}
+
+std::shared_ptr<NPC> Editor::getNPC(NPCHandle handle) const {
+    size_t index = store.indexOf(handle);
+    if (index != NPCStore::npos) {
+        return store.view(index, pool);
     }
     return nullptr;
 }
+
+size_t Editor::queryRadius(double x, double y, double radius, size_t* out, size_t capacity,
+                           const NPCFilter& filter) const {
+    size_t found = 0;
+    queryRadius(x, y, radius, [&](size_t i) {
+        if (found < capacity) {
+            out[found] = i;
+        }
+        ++found;
+    }, filter);
+    return found;
+}
+
+size_t Editor::queryRect(const MapBounds& area, size_t* out, size_t capacity,
+                         const NPCFilter& filter) const {
+    size_t found = 0;
+    queryRect(area, [&](size_t i) {
+        if (found < capacity) {
+            out[found] = i;
+        }
+        ++found;
+    }, filter);
+    return found;
+}
+
+size_t Editor::nearestK(double x, double y, size_t k, size_t* out, const NPCFilter& filter) const {
+    if (k == 0 || store.empty() || std::isnan(x) || std::isnan(y)) {
+        return 0;
+    }
+    const DynamicGrid& grid = queryIndex();
+    // k лучших кандидатов: куча с наибольшим (квадрат расстояния, индекс) в вершине
+    std::vector<std::pair<double, size_t>> best;
+    best.reserve(std::min(k, store.size()));
+    const size_t col = grid.column(x);
+    const size_t row = grid.row(y);
+    for (size_t ring = 0;; ++ring) {
+        bool inside = grid.forEachInRing(col, row, ring, [&](size_t i) {
+            if (!filter.accepts(store, i)) {
+                return;
+            }
+            double dx = store.x(i) - x;
+            double dy = store.y(i) - y;
+            std::pair<double, size_t> candidate(dx * dx + dy * dy, i);
+            if (best.size() < k) {
+                best.push_back(candidate);
+                std::push_heap(best.begin(), best.end());
+            } else if (candidate < best.front()) {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = candidate;
+                std::push_heap(best.begin(), best.end());
+            }
+        });
+        if (!inside) {
+            break;
+        }
+        // NPC за кольцами 0..ring дальше ring клеток; равные по расстоянию
+        // могут оказаться там с меньшим индексом, поэтому сравнение строгое
+        const double reach = (double)ring * grid.getCellSize();
+        if (best.size() == k && best.front().first < reach * reach) {
+            break;
+        }
+    }
+    std::sort_heap(best.begin(), best.end());
+    for (size_t n = 0; n < best.size(); ++n) {
+        out[n] = best[n].second;
+    }
+    return best.size();
+}
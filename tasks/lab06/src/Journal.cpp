@@ -0,0 +1,397 @@
+#include "Journal.h"
+#include "WorldSnapshot.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define BF3_HAVE_FSYNC 1
+#endif
+
+namespace {
+
+// Заголовок журнала и рамка записи
+constexpr size_t HEADER_SIZE = 4 + 4 + 8;
+constexpr size_t FRAME_SIZE = 4 + 8;
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+template <typename T>
+void put(std::vector<char>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+bool get(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+bool getName(std::string_view& in, std::string_view& name) {
+    uint32_t length;
+    if (!get(in, length) || in.size() < length) {
+        return false;
+    }
+    name = in.substr(0, length);
+    in.remove_prefix(length);
+    return true;
+}
+
+// Каталог файла: после переименования в нём синхронизируется запись каталога
+std::string parentDirectory(const std::string& filename) {
+    std::filesystem::path parent = std::filesystem::path(filename).parent_path();
+    return parent.empty() ? std::string(".") : parent.string();
+}
+
+// Перенести восстановленный мир в store (store очищается)
+void replaceWith(NPCStore& store, const NPCStore& loaded) {
+    store.clear();
+    store.reserve(loaded.size());
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        store.add(loaded.type(i), loaded.name(i), loaded.x(i), loaded.y(i));
+        if (!loaded.isAlive(i)) {
+            store.kill(i);
+        }
+    }
+}
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+}  // namespace
+
+Journal::Journal(const std::string& path, const JournalOptions& options)
+    : snapshotPath(path + ".snapshot"), logPath(path + ".log"), options(options) {
+}
+
+Journal::~Journal() {
+    commit();
+    closeFile();
+}
+
+void Journal::closeFile() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool Journal::syncFile(const std::string& filename) const {
+#ifdef BF3_HAVE_FSYNC
+    if (options.durable) {
+        // Каталог открывается так же: fsync сохраняет его записи
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+#else
+    (void)filename;
+#endif
+    return true;
+}
+
+bool Journal::open(NPCStore& store, std::string* error) {
+    closeFile();
+    pending.clear();
+    pendingRecords = 0;
+    replayed = 0;
+    if (!hostIsLittleEndian()) {
+        return fail(error, "журнал поддерживается только на little-endian");
+    }
+
+    uint64_t snapshotId = 0;
+    uint64_t validEnd = 0;
+    uint64_t logSize = 0;
+    // Мир собирается отдельно и заменяет store только при успехе:
+    // испорченный снимок или журнал не уничтожает текущий мир
+    NPCStore loaded;
+    {
+        MappedFile snapshot;
+        MappedFile log;
+        bool haveSnapshot = snapshot.open(snapshotPath);
+        bool haveLog = log.open(logPath);
+
+        // Новый журнал: текущее состояние становится первым снимком
+        if (!haveSnapshot && !haveLog) {
+            return compact(store) || fail(error, "не удалось создать снимок " + snapshotPath);
+        }
+
+        snapshotBytes = 0;
+        if (haveSnapshot) {
+            if (!WorldSnapshot::load(snapshot.view(), loaded, error)) {
+                return false;
+            }
+            // Контрольная сумма снимка служит его идентификатором
+            std::memcpy(&snapshotId, snapshot.view().data() + snapshot.size() - 8, 8);
+            snapshotBytes = snapshot.size();
+        }
+
+        std::string_view data = haveLog ? log.view() : std::string_view();
+        logSize = data.size();
+        if (!data.empty()) {
+            uint32_t version = 0;
+            uint64_t base = 0;
+            if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+                return fail(error, "повреждён заголовок журнала " + logPath);
+            }
+            std::memcpy(&version, data.data() + 4, 4);
+            std::memcpy(&base, data.data() + 8, 8);
+            if (version != VERSION) {
+                return fail(error, "неподдерживаемая версия журнала");
+            }
+            // Журнал от другого снимка уже учтён в нём (сбой посреди сжатия).
+            // Если новый снимок совпал со старым, повтор журнала даёт то же,
+            // что было до сжатия, поэтому совпадение сумм не опасно.
+            if (base == snapshotId) {
+                validEnd = HEADER_SIZE + replay(data.substr(HEADER_SIZE), loaded);
+            }
+        }
+    }
+
+    if (validEnd == 0) {
+        if (!startLog(snapshotId)) {
+            return fail(error, "не удалось создать журнал " + logPath);
+        }
+        replaceWith(store, loaded);
+        return true;
+    }
+    // Оборванный хвост отрезается, чтобы новые записи шли за последней целой
+    if (validEnd < logSize) {
+        std::error_code code;
+        std::filesystem::resize_file(logPath, validEnd, code);
+        if (code) {
+            return fail(error, "не удалось обрезать журнал " + logPath);
+        }
+    }
+    file = std::fopen(logPath.c_str(), "ab");
+    if (!file) {
+        return fail(error, "не удалось открыть журнал " + logPath);
+    }
+    logBytes = validEnd;
+    replaceWith(store, loaded);
+    return true;
+}
+
+size_t Journal::replay(std::string_view records, NPCStore& store) {
+    // Индекс NPC по номеру имени; строится при первом убийстве
+    std::vector<size_t> indexOfName;
+    bool indexValid = false;
+
+    size_t offset = 0;
+    while (records.size() - offset >= FRAME_SIZE) {
+        uint32_t size;
+        uint64_t sum;
+        std::memcpy(&size, records.data() + offset, 4);
+        std::memcpy(&sum, records.data() + offset + 4, 8);
+        if (size == 0 || size > records.size() - offset - FRAME_SIZE) {
+            break;
+        }
+        std::string_view in = records.substr(offset + FRAME_SIZE, size);
+        if (WorldSnapshot::checksum(in.data(), in.size()) != sum) {
+            break;
+        }
+
+        uint8_t op;
+        std::string_view name;
+        if (!get(in, op)) {
+            break;
+        }
+        if (op == static_cast<uint8_t>(Op::Add)) {
+            uint8_t type;
+            double x, y;
+            if (!get(in, type) || type >= NPC_TYPE_COUNT || !get(in, x) || !get(in, y) ||
+                !getName(in, name)) {
+                break;
+            }
+            if (!name.empty() && !store.containsName(name)) {
+                size_t i = store.add(static_cast<NPCType>(type), name, x, y);
+                if (indexValid) {
+                    NameId id = store.nameId(i);
+                    if (id >= indexOfName.size()) {
+                        indexOfName.resize(id + 1, NPCStore::npos);
+                    }
+                    indexOfName[id] = i;
+                }
+            }
+        } else if (op == static_cast<uint8_t>(Op::Kill)) {
+            if (!getName(in, name)) {
+                break;
+            }
+            if (!indexValid) {
+                indexOfName.assign(store.nameTable().size(), NPCStore::npos);
+                for (size_t i = 0; i < store.size(); ++i) {
+                    NameId id = store.nameId(i);
+                    if (id >= indexOfName.size()) {
+                        indexOfName.resize(id + 1, NPCStore::npos);
+                    }
+                    indexOfName[id] = i;
+                }
+                indexValid = true;
+            }
+            NameId id;
+            if (store.nameTable().find(name, id) && id < indexOfName.size() &&
+                indexOfName[id] != NPCStore::npos) {
+                store.kill(indexOfName[id]);
+            }
+        } else if (op == static_cast<uint8_t>(Op::RemoveDead)) {
+            store.removeDead();
+            indexValid = false;
+        } else if (op == static_cast<uint8_t>(Op::Clear)) {
+            store.clear();
+            indexValid = false;
+        } else {
+            break;
+        }
+        offset += FRAME_SIZE + size;
+        ++replayed;
+    }
+    return offset;
+}
+
+bool Journal::startLog(uint64_t snapshotId) {
+    closeFile();
+    // Новый журнал пишется рядом и подменяет старый одним переименованием
+    const std::string tmp = logPath + ".tmp";
+    {
+        std::vector<char> header;
+        header.insert(header.end(), MAGIC, MAGIC + sizeof(MAGIC));
+        put<uint32_t>(header, VERSION);
+        put<uint64_t>(header, snapshotId);
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(header.data(), (std::streamsize)header.size());
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    if (!syncFile(tmp)) {
+        return false;
+    }
+    std::error_code code;
+    std::filesystem::rename(tmp, logPath, code);
+    if (code || !syncFile(parentDirectory(logPath))) {
+        return false;
+    }
+    file = std::fopen(logPath.c_str(), "ab");
+    logBytes = HEADER_SIZE;
+    return file != nullptr;
+}
+
+void Journal::append(Op op, NPCType type, std::string_view name, double x, double y) {
+    if (!file) {
+        return;
+    }
+    const size_t start = pending.size();
+    pending.resize(start + FRAME_SIZE);
+    put<uint8_t>(pending, static_cast<uint8_t>(op));
+    if (op == Op::Add) {
+        put<uint8_t>(pending, static_cast<uint8_t>(type));
+        put<double>(pending, x);
+        put<double>(pending, y);
+    }
+    if (op == Op::Add || op == Op::Kill) {
+        put<uint32_t>(pending, (uint32_t)name.size());
+        pending.insert(pending.end(), name.begin(), name.end());
+    }
+    const uint32_t size = (uint32_t)(pending.size() - start - FRAME_SIZE);
+    const uint64_t sum = WorldSnapshot::checksum(pending.data() + start + FRAME_SIZE, size);
+    std::memcpy(pending.data() + start, &size, 4);
+    std::memcpy(pending.data() + start + 4, &sum, 8);
+
+    if (++pendingRecords >= options.groupCommit) {
+        commit();
+    }
+}
+
+void Journal::add(NPCType type, std::string_view name, double x, double y) {
+    append(Op::Add, type, name, x, y);
+}
+
+void Journal::kill(std::string_view name) {
+    append(Op::Kill, NPCType::Dragon, name, 0, 0);
+}
+
+void Journal::removeDead() {
+    append(Op::RemoveDead, NPCType::Dragon, {}, 0, 0);
+}
+
+void Journal::clear() {
+    append(Op::Clear, NPCType::Dragon, {}, 0, 0);
+}
+
+bool Journal::commit() {
+    if (!file) {
+        return false;
+    }
+    if (pending.empty()) {
+        return true;
+    }
+    // Вся группа — одна запись в файл и один fsync
+    bool ok = std::fwrite(pending.data(), 1, pending.size(), file) == pending.size() &&
+              std::fflush(file) == 0;
+#ifdef BF3_HAVE_FSYNC
+    if (ok && options.durable) {
+        ok = ::fsync(fileno(file)) == 0;
+    }
+#endif
+    if (ok) {
+        logBytes += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+    }
+    return ok;
+}
+
+bool Journal::needsCompaction() const {
+    return options.compactBytes != 0 && logBytes > options.compactBytes &&
+           logBytes > snapshotBytes;
+}
+
+bool Journal::compact(const NPCStore& store) {
+    if (file && !commit()) {
+        return false;
+    }
+    // Снимок пишется во временный файл и подменяет старый переименованием;
+    // до появления нового журнала старый ссылается на прежний снимок
+    const std::string tmp = snapshotPath + ".tmp";
+    if (!WorldSnapshot::save(store, tmp) || !syncFile(tmp)) {
+        return false;
+    }
+    uint64_t snapshotId = 0;
+    {
+        std::ifstream in(tmp, std::ios::binary | std::ios::ate);
+        snapshotBytes = (uint64_t)in.tellg();
+        in.seekg(-8, std::ios::end);
+        in.read(reinterpret_cast<char*>(&snapshotId), 8);
+        if (!in) {
+            return false;
+        }
+    }
+    std::error_code code;
+    std::filesystem::rename(tmp, snapshotPath, code);
+    if (code || !syncFile(parentDirectory(snapshotPath))) {
+        return false;
+    }
+    return startLog(snapshotId);
+}
@@ -0,0 +1,111 @@
+#include "KillEventPipeline.h"
+#include <chrono>
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Самый долгий сон потребителя без пробуждения
+constexpr std::chrono::milliseconds PARK_TIMEOUT{10};
+
+// Ожидание производителя без блокировок: сначала уступаем процессор, затем засыпаем
+void backoff(unsigned& spins) {
+    if (++spins < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+}  // namespace
+
+KillEventPipeline::KillEventPipeline(size_t capacity, Backpressure policy, Sink sink)
+    : ring(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)),
+      mask(ring.size() - 1),
+      policy(policy),
+      sink(std::move(sink)) {
+    consumer = std::thread(&KillEventPipeline::consume, this);
+}
+
+KillEventPipeline::~KillEventPipeline() {
+    drain();
+    stopping.store(true);
+    wakeConsumer();
+    consumer.join();
+}
+
+bool KillEventPipeline::push(const KillEvent& event) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    unsigned spins = 0;
+    while (t - h >= ring.size()) {
+        if (policy == Backpressure::Drop) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        backoff(spins);
+        h = head.load(std::memory_order_acquire);
+    }
+    ring[t & mask] = event;
+    if (t == h) {
+        // Очередь была пуста, и потребитель мог уснуть. Полный порядок с parked:
+        // либо потребитель увидит новый tail, либо производитель — его сон.
+        tail.store(t + 1);
+        wakeConsumer();
+    } else {
+        // Потребитель ещё разбирает очередь; дешёвая запись без барьера
+        tail.store(t + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+void KillEventPipeline::wakeConsumer() {
+    if (parked.load()) {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        wake.notify_one();
+    }
+}
+
+void KillEventPipeline::drain() {
+    const size_t target = tail.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeConsumer();
+    unsigned spins = 0;
+    while (head.load(std::memory_order_acquire) != target) {
+        backoff(spins);
+    }
+}
+
+void KillEventPipeline::consume() {
+    unsigned spins = 0;
+    while (true) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            if (stopping.load()) {
+                return;
+            }
+            // Короткая серия уступок ловит следующее событие пачки,
+            // дальше поток спит до push или остановки
+            if (++spins < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Событие, записанное без барьера, пока поток засыпал, дождётся
+            // таймаута или следующего drain
+            std::unique_lock<std::mutex> lock(parkMutex);
+            parked.store(true);
+            wake.wait_for(lock, PARK_TIMEOUT, [&] { return h != tail.load() || stopping.load(); });
+            parked.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        spins = 0;
+        sink(ring[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+    }
+}
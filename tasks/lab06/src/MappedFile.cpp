@@ -0,0 +1,67 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BF3_HAVE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() {
+#ifdef BF3_HAVE_MMAP
+    if (mapped) {
+        munmap(const_cast<char*>(data), length);
+    }
+#endif
+    data = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    release();
+#ifdef BF3_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    length = (size_t)info.st_size;
+    if (length > 0) {
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        // Файл читается один раз от начала до конца
+        madvise(addr, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(addr);
+        mapped = true;
+    }
+    ::close(fd);
+    return true;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(buffer.data(), (std::streamsize)buffer.size());
+    data = buffer.data();
+    length = buffer.size();
+    return true;
+#endif
+}
@@ -1,7 +1,9 @@
 #include "NPC.h"
+#include "NPCStore.h"
+#include "NPCTypes.h"
 
-NPC::NPC(const std::string& name, double x, double y) 
-    : name(name), x(x), y(y), alive(true) {}
+NPC::NPC(std::string_view name, double x, double y, NPCType type) 
+    : name(name), x(x), y(y), alive(true), type(type) {}
 
 double NPC::distanceTo(const NPC& other) const {
     double dx = x - other.x;
@@ -9,7 +11,25 @@ double NPC::distanceTo(const NPC& other) const {
     return std::sqrt(dx * dx + dy * dy);
 }
 
+void NPC::accept(BattleVisitor& visitor, NPC& other) {
+    NPCTypes::dispatch(visitor, *this, other);
+}
+
+void NPC::kill() {
+    alive = false;
+    if (link.store) {
+        link.store->kill(link.slot);
+    }
+}
+
 std::string NPC::toString() const {
-    return getType() + " '" + name + "' в точке (" + 
+    return format(type, name, x, y);
+}
+
+std::string NPC::format(NPCType type, std::string_view name, double x, double y) {
+    std::string result(npcTypeName(type));
+    result += " '";
+    result += name;
+    return result + "' в точке (" + 
            std::to_string((int)x) + ", " + std::to_string((int)y) + ")";
 }
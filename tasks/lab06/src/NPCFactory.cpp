@@ -1,29 +1,128 @@
 #include "NPCFactory.h"
-#include "Dragon.h"
-#include "Bull.h"
-#include "Frog.h"
-#include <sstream>
+#include "NPCTypes.h"
+#include "NPCPool.h"
+#include <charconv>
 
 std::shared_ptr<NPC> NPCFactory::createNPC(const std::string& type, 
-                                           const std::string& name, 
+                                           std::string_view name, 
                                            double x, double y) {
-    if (type == "Dragon") {
-        return std::make_shared<Dragon>(name, x, y);
-    } else if (type == "Bull") {
-        return std::make_shared<Bull>(name, x, y);
-    } else if (type == "Frog") {
-        return std::make_shared<Frog>(name, x, y);
+    NPCType tag;
+    if (!parseType(type, tag)) {
+        return nullptr;
+    }
+    return createNPC(tag, name, x, y);
+}
+
+std::shared_ptr<NPC> NPCFactory::createNPC(NPCType type, 
+                                           std::string_view name, 
+                                           double x, double y) {
+    return NPCTypes::create(type, name, x, y);
+}
+
+std::shared_ptr<NPC> NPCFactory::createNPC(NPCType type, 
+                                           std::string_view name, 
+                                           double x, double y, 
+                                           NPCPool& pool) {
+    return pool.create(type, name, x, y);
+}
+
+bool NPCFactory::parseType(std::string_view typeName, NPCType& type) {
+    // Совершенный хеш по именам из реестра: без цепочки сравнений строк
+    return NPCTypes::parse(typeName, type);
+}
+
+namespace {
+
+// Пробельные символы в смысле std::isspace для локали "C"
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+void skipSpaces(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) {
+        ++p;
     }
-    return nullptr;
+}
+
+std::string_view readToken(const char*& p, const char* end) {
+    skipSpaces(p, end);
+    const char* begin = p;
+    while (p < end && !isSpace(*p)) {
+        ++p;
+    }
+    return std::string_view(begin, (size_t)(p - begin));
+}
+
+// Число в записи, которую принимает operator>> для double (в том числе с ведущим '+')
+bool readNumber(const char*& p, const char* end, double& value) {
+    skipSpaces(p, end);
+    const char* begin = p;
+    // std::from_chars не принимает '+', а поток принимает
+    bool plus = begin < end && *begin == '+';
+    if (plus) {
+        ++begin;
+    }
+    const char* digits = begin;
+    if (!plus && digits < end && *digits == '-') {
+        ++digits;
+    }
+    // Отсекаем "inf" и "nan", которые поток не читает
+    if (digits >= end || !((*digits >= '0' && *digits <= '9') || *digits == '.')) {
+        return false;
+    }
+    auto result = std::from_chars(begin, end, value, std::chars_format::general);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+}  // namespace
+
+bool NPCFactory::parseRecord(std::string_view line, NPCRecord& record, const char** error) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    const char* reason = nullptr;
+
+    // Формат: Type Name X Y
+    std::string_view typeName = readToken(p, end);
+    record.name = readToken(p, end);
+    if (typeName.empty() || record.name.empty()) {
+        reason = "ожидается: Type Name X Y";
+    } else if (!parseType(typeName, record.type)) {
+        reason = "неизвестный тип NPC";
+    } else if (!readNumber(p, end, record.x)) {
+        reason = "некорректная координата X";
+    } else if (!readNumber(p, end, record.y)) {
+        reason = "некорректная координата Y";
+    }
+
+    if (reason && error) {
+        *error = reason;
+    }
+    return reason == nullptr;
+}
+
+bool NPCFactory::parseLine(const std::string& line, NPCType& type, 
+                           std::string& name, double& x, double& y) {
+    NPCRecord record;
+    if (!parseRecord(line, record)) {
+        return false;
+    }
+    type = record.type;
+    name.assign(record.name);
+    x = record.x;
+    y = record.y;
+    return true;
 }
 
 std::shared_ptr<NPC> NPCFactory::loadFromString(const std::string& line) {
-    std::istringstream iss(line);
-    std::string type, name;
+    NPCType type;
+    std::string name;
     double x, y;
     
-    // Формат: Type Name X Y
-    if (iss >> type >> name >> x >> y) {
+    if (parseLine(line, type, name, x, y)) {
         return createNPC(type, name, x, y);
     }
     
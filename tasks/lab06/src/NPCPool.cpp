@@ -0,0 +1,37 @@
+#include "NPCPool.h"
+
+NPCPool::Arena& NPCPool::getArena() {
+    if (!arena) {
+        arena = std::make_shared<Arena>();
+    }
+    return *arena;
+}
+
+std::shared_ptr<NPC> NPCPool::create(NPCType type, std::string_view name, double x, double y) {
+    Arena& a = getArena();
+    NPC* npc = nullptr;
+    NPCTypes::forType(type, [&](auto tag) {
+        using T = typename decltype(tag)::type;
+        npc = std::get<SlabPool<T>>(a).create(name, x, y);
+    });
+    // Псевдоним на общий счётчик арены: без выделения памяти на объект
+    return std::shared_ptr<NPC>(arena, npc);
+}
+
+void NPCPool::reserve(NPCType type, size_t count) {
+    Arena& a = getArena();
+    NPCTypes::forType(type, [&](auto tag) {
+        std::get<SlabPool<typename decltype(tag)::type>>(a).reserve(count);
+    });
+}
+
+size_t NPCPool::size() const {
+    if (!arena) {
+        return 0;
+    }
+    size_t total = 0;
+    NPCTypes::forEachType([&](auto tag) {
+        total += std::get<SlabPool<typename decltype(tag)::type>>(*arena).size();
+    });
+    return total;
+}
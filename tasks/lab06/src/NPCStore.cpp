@@ -0,0 +1,260 @@
+#include "NPCStore.h"
+#include "NPCFactory.h"
+#include <algorithm>
+
+NPCStore::~NPCStore() {
+    clear();
+}
+
+void NPCStore::reserve(size_t count) {
+    xs.reserve(count);
+    ys.reserve(count);
+    types.reserve(count);
+    alive.reserve(count);
+    nameIds.reserve(count);
+    slotOf.reserve(count);
+    views.reserve(count);
+    names.reserve(count);
+    indexOfSlot.reserve(count);
+    generations.reserve(count);
+}
+
+size_t NPCStore::add(NPCType type, std::string_view name, double x, double y) {
+    return append(type, names.intern(name), x, y);
+}
+
+size_t NPCStore::addUnique(NPCType type, std::string_view name, double x, double y) {
+    NameId id;
+    if (!names.internNew(name, id)) {
+        return npos;
+    }
+    return append(type, id, x, y);
+}
+
+size_t NPCStore::append(NPCType type, NameId name, double x, double y) {
+    xs.push_back(x);
+    ys.push_back(y);
+    types.push_back(type);
+    alive.push_back(1);
+    nameIds.push_back(name);
+    slotOf.push_back(acquireSlot(xs.size() - 1));
+    views.emplace_back();
+    if (spatial) {
+        spatial->insert(xs.size() - 1, x, y);
+    }
+    return xs.size() - 1;
+}
+
+uint32_t NPCStore::acquireSlot(size_t index) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = (uint32_t)generations.size();
+        generations.push_back(0);
+        indexOfSlot.push_back(0);
+    }
+    indexOfSlot[slot] = (uint32_t)index;
+    return slot;
+}
+
+size_t NPCStore::add(const std::shared_ptr<NPC>& npc) {
+    size_t slot = add(npc->getTypeTag(), npc->getName(), npc->getX(), npc->getY());
+    if (!npc->isAlive()) {
+        kill(slot);
+    }
+    // Объект из другого редактора не перепривязывается: его слот хранится там
+    if (npc->link.store == nullptr) {
+        attach(npc, slot);
+    }
+    return slot;
+}
+
+void NPCStore::attach(const std::shared_ptr<NPC>& npc, size_t slot) const {
+    npc->link.store = const_cast<NPCStore*>(this);
+    npc->link.slot = slot;
+    views[slot] = npc;
+}
+
+void NPCStore::detach(NPC& npc) {
+    npc.link.store = nullptr;
+    npc.link.slot = 0;
+}
+
+void NPCStore::kill(size_t i) {
+    if (killLog && alive[i]) {
+        killLog->push_back((uint32_t)i);
+    }
+    alive[i] = 0;
+    if (views[i]) {
+        views[i]->alive = false;
+    }
+    // Погибшие остаются в индексе для запросов, но поиск противников их не видит
+    if (spatial) {
+        spatial->park(i);
+    }
+}
+
+bool NPCStore::applyOutcome(size_t attacker, size_t defender, BattleOutcome outcome) {
+    if (!alive[attacker] || !alive[defender]) {
+        return false;
+    }
+    switch (outcome) {
+        case BattleOutcome::AttackerKills:
+            kill(defender);
+            return true;
+        case BattleOutcome::MutualKill:
+            kill(attacker);
+            kill(defender);
+            return true;
+        case BattleOutcome::None:
+            break;
+    }
+    return false;
+}
+
+void NPCStore::setPosition(size_t i, double x, double y) {
+    xs[i] = x;
+    ys[i] = y;
+    if (spatial) {
+        spatial->move(i, x, y);
+    }
+    if (views[i]) {
+        views[i]->x = x;
+        views[i]->y = y;
+    }
+}
+
+void NPCStore::moveEntry(size_t from, size_t to) {
+    xs[to] = xs[from];
+    ys[to] = ys[from];
+    types[to] = types[from];
+    alive[to] = alive[from];
+    nameIds[to] = nameIds[from];
+    slotOf[to] = slotOf[from];
+    indexOfSlot[slotOf[to]] = (uint32_t)to;
+    views[to] = std::move(views[from]);
+    if (views[to]) {
+        views[to]->link.slot = to;
+    }
+    if (spatial) {
+        spatial->insert(to, xs[to], ys[to]);
+        if (!alive[to]) {
+            spatial->park(to);
+        }
+        spatial->remove(from);
+    }
+}
+
+void NPCStore::popBack() {
+    if (spatial) {
+        spatial->remove(xs.size() - 1);
+    }
+    xs.pop_back();
+    ys.pop_back();
+    types.pop_back();
+    alive.pop_back();
+    nameIds.pop_back();
+    slotOf.pop_back();
+    views.pop_back();
+}
+
+size_t NPCStore::removeDead(size_t prefix) {
+    prefix = std::min(prefix, xs.size());
+    // Проход с конца: всё, что правее i, уже живое и годится для переноса
+    for (size_t i = xs.size(); i-- > 0;) {
+        if (alive[i]) {
+            continue;
+        }
+        names.release(nameIds[i]);
+        if (views[i]) {
+            detach(*views[i]);
+            views[i].reset();
+        }
+        // Старые ссылки на этого NPC становятся недействительными
+        ++generations[slotOf[i]];
+        freeSlots.push_back(slotOf[i]);
+
+        size_t last = xs.size() - 1;
+        if (i < prefix) {
+            --prefix;
+            if (i != prefix) {
+                moveEntry(prefix, i);
+            }
+            if (prefix != last) {
+                moveEntry(last, prefix);
+            }
+        } else if (i != last) {
+            moveEntry(last, i);
+        }
+        popBack();
+    }
+    return prefix;
+}
+
+void NPCStore::clear() {
+    for (auto& npc : views) {
+        if (npc) {
+            detach(*npc);
+        }
+    }
+    xs.clear();
+    ys.clear();
+    types.clear();
+    alive.clear();
+    nameIds.clear();
+    names.clear();
+    views.clear();
+    // Все ячейки освобождаются; поколения сохраняются, чтобы старые ссылки не ожили
+    for (uint32_t slot : slotOf) {
+        ++generations[slot];
+    }
+    slotOf.clear();
+    freeSlots.clear();
+    for (size_t slot = generations.size(); slot-- > 0;) {
+        freeSlots.push_back((uint32_t)slot);
+    }
+    if (spatial) {
+        spatial->reset(0);
+    }
+}
+
+const DynamicGrid& NPCStore::spatialIndex(const MapBounds& bounds, double cellSize) const {
+    // Построенный индекс читается без блокировки; первые запросы из разных
+    // потоков строят его один раз
+    if (!spatialBuilt.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(spatialMutex);
+        if (!spatial) {
+            auto grid = std::make_unique<DynamicGrid>(bounds, cellSize);
+            grid->reset(xs.size());
+            for (size_t i = 0; i < xs.size(); ++i) {
+                grid->insert(i, xs[i], ys[i]);
+                if (!alive[i]) {
+                    grid->park(i);
+                }
+            }
+            spatial = std::move(grid);
+        }
+        spatialBuilt.store(true, std::memory_order_release);
+    }
+    return *spatial;
+}
+
+std::shared_ptr<NPC> NPCStore::view(size_t i) const {
+    if (!views[i]) {
+        auto npc = NPCFactory::createNPC(types[i], name(i), xs[i], ys[i]);
+        npc->alive = alive[i] != 0;
+        attach(npc, i);
+    }
+    return views[i];
+}
+
+std::shared_ptr<NPC> NPCStore::view(size_t i, NPCPool& pool) const {
+    if (!views[i]) {
+        auto npc = NPCFactory::createNPC(types[i], name(i), xs[i], ys[i], pool);
+        npc->alive = alive[i] != 0;
+        attach(npc, i);
+    }
+    return views[i];
+}
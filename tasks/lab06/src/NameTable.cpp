@@ -0,0 +1,77 @@
+#include "NameTable.h"
+
+NameId NameTable::intern(std::string_view name) {
+    auto it = index.find(name);
+    if (it != index.end()) {
+        ++refs[it->second];
+        return it->second;
+    }
+    return insert(name);
+}
+
+bool NameTable::internNew(std::string_view name, NameId& id) {
+    // Имя сразу кладётся в таблицу, и ключ индекса указывает на него: проверка
+    // и вставка — один поиск в хеше. Уже известное имя откатывается.
+    NameId placed = place(name);
+    if (!index.try_emplace(slot(placed), placed).second) {
+        slot(placed).clear();
+        freeIds.push_back(placed);
+        return false;
+    }
+    id = placed;
+    return true;
+}
+
+NameId NameTable::insert(std::string_view name) {
+    NameId id = place(name);
+    index.emplace(slot(id), id);
+    return id;
+}
+
+NameId NameTable::place(std::string_view name) {
+    NameId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+        slot(id) = name;
+        refs[id] = 1;
+    } else {
+        id = (NameId)count;
+        const size_t block = blockOf(id);
+        if (!blocks[block]) {
+            blocks[block] = std::make_unique<std::string[]>(FIRST_BLOCK << block);
+        }
+        slot(id) = name;
+        refs.push_back(1);
+        ++count;
+    }
+    return id;
+}
+
+void NameTable::release(NameId id) {
+    if (--refs[id] != 0) {
+        return;
+    }
+    index.erase(slot(id));
+    slot(id).clear();
+    freeIds.push_back(id);
+}
+
+bool NameTable::find(std::string_view name, NameId& id) const {
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+void NameTable::clear() {
+    index.clear();
+    for (auto& block : blocks) {
+        block.reset();
+    }
+    count = 0;
+    refs.clear();
+    freeIds.clear();
+}
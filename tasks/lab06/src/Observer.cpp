@@ -1,16 +1,74 @@
 #include "Observer.h"
 #include <iostream>
 
-void ConsoleObserver::onKill(const std::string& killer, const std::string& victim) {
-    std::cout << "[СОБЫТИЕ] " << killer << " убил " << victim << std::endl;
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+void KillEvent::appendText(std::string& out) const {
+    out += killerName();
+    if (mutual) {
+        out += " и ";
+        out += victimName();
+        out += " убил друг друга";
+    } else {
+        out += " убил ";
+        out += victimName();
+    }
 }
 
-FileObserver::FileObserver(const std::string& filename) : filename(filename) {}
+ConsoleObserver::ConsoleObserver() : out(std::cout) {}
 
-void FileObserver::onKill(const std::string& killer, const std::string& victim) {
-    std::ofstream file(filename, std::ios::app);
-    if (file.is_open()) {
-        file << "[СОБЫТИЕ] " << killer << " убил " << victim << std::endl;
-        file.close();
+void ConsoleObserver::onKill(const KillEvent& event) {
+    line = "[СОБЫТИЕ] ";
+    event.appendText(line);
+    // Строка выводится одной записью
+    line += '\n';
+    out << line << std::flush;
+}
+
+FileObserver::FileObserver(const std::string& filename, size_t bufferSize, FsyncPolicy fsyncPolicy) 
+    : filename(filename), flushThreshold(bufferSize), fsyncPolicy(fsyncPolicy) {
+    file = std::fopen(filename.c_str(), "a");
+    if (file) {
+        // Буферизация ведётся здесь, буфер stdio не нужен
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    }
+    buffer.reserve(flushThreshold + 256);
+}
+
+FileObserver::~FileObserver() {
+    flush();
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+void FileObserver::onKill(const KillEvent& event) {
+    if (!file) {
+        return;
+    }
+    buffer += "[СОБЫТИЕ] ";
+    event.appendText(buffer);
+    buffer += '\n';
+    if (buffer.size() >= flushThreshold) {
+        flush();
+    }
+}
+
+void FileObserver::onBattleEnd() {
+    flush();
+}
+
+void FileObserver::flush() {
+    if (!file || buffer.empty()) {
+        return;
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    buffer.clear();
+#if defined(__unix__) || defined(__APPLE__)
+    if (fsyncPolicy == FsyncPolicy::OnFlush) {
+        fsync(fileno(file));
     }
+#endif
 }
@@ -0,0 +1,86 @@
+#include "RangeKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void rangeMaskScalar(double x, double y,
+                     const double* xs, const double* ys, size_t count,
+                     double rangeSq, uint64_t* mask) {
+    for (size_t w = 0; w < rangeMaskWords(count); ++w) {
+        mask[w] = 0;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        double dx = xs[k] - x;
+        double dy = ys[k] - y;
+        if (dx * dx + dy * dy <= rangeSq) {
+            mask[k / 64] |= uint64_t(1) << (k % 64);
+        }
+    }
+}
+
+void rangeMask(double x, double y,
+               const double* xs, const double* ys, size_t count,
+               double rangeSq, uint64_t* mask) {
+#if defined(__AVX2__)
+    const __m256d px = _mm256_set1_pd(x);
+    const __m256d py = _mm256_set1_pd(y);
+    const __m256d r2 = _mm256_set1_pd(rangeSq);
+    for (size_t w = 0; w < rangeMaskWords(count); ++w) {
+        mask[w] = 0;
+    }
+    // По 4 кандидата за шаг; 4 делит 64, поэтому блок не пересекает границу слова
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + k), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + k), py);
+        __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        uint64_t hit = (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(d2, r2, _CMP_LE_OQ));
+        mask[k / 64] |= hit << (k % 64);
+    }
+    for (; k < count; ++k) {
+        double dx = xs[k] - x;
+        double dy = ys[k] - y;
+        if (dx * dx + dy * dy <= rangeSq) {
+            mask[k / 64] |= uint64_t(1) << (k % 64);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128d px = _mm_set1_pd(x);
+    const __m128d py = _mm_set1_pd(y);
+    const __m128d r2 = _mm_set1_pd(rangeSq);
+    for (size_t w = 0; w < rangeMaskWords(count); ++w) {
+        mask[w] = 0;
+    }
+    // По 2 кандидата за шаг
+    size_t k = 0;
+    for (; k + 2 <= count; k += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + k), px);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + k), py);
+        __m128d d2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        uint64_t hit = (uint64_t)_mm_movemask_pd(_mm_cmple_pd(d2, r2));
+        mask[k / 64] |= hit << (k % 64);
+    }
+    for (; k < count; ++k) {
+        double dx = xs[k] - x;
+        double dy = ys[k] - y;
+        if (dx * dx + dy * dy <= rangeSq) {
+            mask[k / 64] |= uint64_t(1) << (k % 64);
+        }
+    }
+#else
+    rangeMaskScalar(x, y, xs, ys, count, rangeSq, mask);
+#endif
+}
+
+const char* rangeMaskBackend() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,120 @@
+#include "Simulation.h"
+#include "Editor.h"
+#include "BattleVisitor.h"
+#include "BattleStats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::nanoseconds since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+}
+
+double clampToMap(double value) {
+    return std::min(std::max(value, 0.0), Editor::MAP_SIZE);
+}
+
+}  // namespace
+
+Simulation::Simulation(Editor& editor, const SimulationConfig& config)
+    : editor(editor), config(config), rngState(config.seed) {}
+
+double Simulation::random01() {
+    // splitmix64: быстрый и воспроизводимый генератор
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (double)(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void Simulation::prepare() {
+    if (config.movement != MovementMode::Waypoint) {
+        return;
+    }
+    // Новым NPC (и тем, кто занял слот удалённого) нужны цели; у остальных
+    // цели сохраняются, даже если их индекс сменился
+    const NPCStore& store = editor.getStore();
+    for (size_t i = 0; i < store.size(); ++i) {
+        NPCHandle handle = store.handle(i);
+        if (handle.slot >= targetOf.size()) {
+            targetX.resize(handle.slot + 1);
+            targetY.resize(handle.slot + 1);
+            targetOf.resize(handle.slot + 1);
+        }
+        if (targetOf[handle.slot] != handle) {
+            targetOf[handle.slot] = handle;
+            targetX[handle.slot] = random01() * Editor::MAP_SIZE;
+            targetY[handle.slot] = random01() * Editor::MAP_SIZE;
+        }
+    }
+}
+
+void Simulation::moveAll() {
+    const NPCStore& store = editor.getStore();
+    const double step = config.speed * config.timeStep;
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (!store.isAlive(i)) {
+            continue;
+        }
+        double x = store.x(i);
+        double y = store.y(i);
+        if (config.movement == MovementMode::RandomWalk) {
+            x += (2 * random01() - 1) * step;
+            y += (2 * random01() - 1) * step;
+        } else {
+            const uint32_t slot = store.handle(i).slot;
+            double dx = targetX[slot] - x;
+            double dy = targetY[slot] - y;
+            double distance = std::sqrt(dx * dx + dy * dy);
+            if (distance <= step) {
+                x = targetX[slot];
+                y = targetY[slot];
+                targetX[slot] = random01() * Editor::MAP_SIZE;
+                targetY[slot] = random01() * Editor::MAP_SIZE;
+            } else {
+                x += dx / distance * step;
+                y += dy / distance * step;
+            }
+        }
+        // Индекс хранилища обновляется тут же
+        editor.moveNPC(i, clampToMap(x), clampToMap(y));
+    }
+}
+
+void Simulation::run(size_t ticks, BattleVisitor& visitor) {
+    prepare();
+    const NPCStore& store = editor.getStore();
+    size_t alive = 0;
+    for (size_t i = 0; i < store.size(); ++i) {
+        alive += store.isAlive(i) ? 1 : 0;
+    }
+
+    for (size_t tick = 0; tick < ticks; ++tick) {
+        TickTiming timing;
+        Clock::time_point start = Clock::now();
+        moveAll();
+        timing.moveTime = since(start);
+
+        start = Clock::now();
+        BattleStats stats;
+        editor.resolveMoving(config.range, visitor, &stats);
+        timing.battleTime = since(start);
+        timing.kills = (size_t)stats.totalKills();
+
+        alive -= timing.kills;
+        timing.alive = alive;
+        timings.push_back(timing);
+    }
+
+    visitor.drain();
+    visitor.notifyBattleEnd();
+
+    // Перемещения в журнал не пишутся: мир после прогона становится новым снимком
+    if (editor.hasJournal()) {
+        editor.compactJournal();
+    }
+}
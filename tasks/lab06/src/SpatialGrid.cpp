@@ -0,0 +1,57 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(double minX, double minY, double maxX, double maxY, double range)
+    : minX(minX), minY(minY) {
+    double span = std::max(maxX - minX, maxY - minY);
+    // Клетка не меньше радиуса, но и не мельче предела по числу клеток
+    cellSize = std::max(range, span / MAX_CELLS_PER_AXIS);
+    if (!(cellSize > 0)) {
+        cellSize = 1.0;
+    }
+    width = std::max<size_t>(1, (size_t)std::ceil((maxX - minX) / cellSize));
+    height = std::max<size_t>(1, (size_t)std::ceil((maxY - minY) / cellSize));
+    width = std::min(width, MAX_CELLS_PER_AXIS);
+    height = std::min(height, MAX_CELLS_PER_AXIS);
+}
+
+size_t SpatialGrid::cellCoord(double value, double origin, size_t cells) const {
+    // Точки за пределами карты прижимаются к крайним клеткам:
+    // это не нарушает правило "сосед в пределах радиуса — в соседней клетке"
+    double c = std::floor((value - origin) / cellSize);
+    if (!(c > 0)) {
+        return 0;
+    }
+    if (c >= (double)(cells - 1)) {
+        return cells - 1;
+    }
+    return (size_t)c;
+}
+
+void SpatialGrid::build(const std::vector<double>& xs, const std::vector<double>& ys) {
+    size_t count = xs.size();
+    std::vector<size_t> cellOf(count);
+
+    // Подсчёт точек в клетках
+    cellStart.assign(width * height + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        cellOf[i] = cellCoord(ys[i], minY, height) * width + cellCoord(xs[i], minX, width);
+        ++cellStart[cellOf[i] + 1];
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    // Раскладка по клеткам с сохранением исходного порядка
+    items.resize(count);
+    itemX.resize(count);
+    itemY.resize(count);
+    std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        size_t slot = fill[cellOf[i]]++;
+        items[slot] = i;
+        itemX[slot] = xs[i];
+        itemY[slot] = ys[i];
+    }
+}
@@ -0,0 +1,65 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t k = 1; k < threads; ++k) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::runTasks() {
+    for (size_t k = nextIndex.fetch_add(1); k < taskCount; k = nextIndex.fetch_add(1)) {
+        (*task)(k);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        lock.unlock();
+        runTasks();
+        lock.lock();
+        if (--busy == 0) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func) {
+    if (workers.empty() || count <= 1) {
+        for (size_t k = 0; k < count; ++k) {
+            func(k);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &func;
+        taskCount = count;
+        nextIndex.store(0);
+        busy = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy == 0; });
+    task = nullptr;
+}
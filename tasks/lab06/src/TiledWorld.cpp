@@ -0,0 +1,322 @@
+#include "TiledWorld.h"
+#include "BattleVisitor.h"
+#include "BattleRules.h"
+#include "MappedFile.h"
+#include "RangeKernel.h"
+#include "WorldSnapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+// Исход боя пары из разных плиток (как NPCStore::applyOutcome)
+bool applyAcross(NPCStore& attackers, size_t attacker, NPCStore& defenders, size_t defender,
+                 BattleOutcome outcome) {
+    if (outcome == BattleOutcome::None || !attackers.isAlive(attacker) || !defenders.isAlive(defender)) {
+        return false;
+    }
+    if (outcome == BattleOutcome::MutualKill) {
+        attackers.kill(attacker);
+    }
+    defenders.kill(defender);
+    return true;
+}
+
+// Соседи плитки, идущие после неё в порядке ключей: справа, слева снизу, снизу, справа снизу
+constexpr int LATER_NEIGHBOURS[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+}  // namespace
+
+TiledWorld::TiledWorld(const TiledWorldConfig& config) : config(config) {
+    this->config.tilesX = std::max<size_t>(1, config.tilesX);
+    this->config.tilesY = std::max<size_t>(1, config.tilesY);
+
+    std::error_code code;
+    std::filesystem::create_directories(config.directory, code);
+    for (const auto& entry : std::filesystem::directory_iterator(config.directory, code)) {
+        const std::string name = entry.path().filename().string();
+        size_t tx, ty;
+        if (std::sscanf(name.c_str(), "tile_%zu_%zu.bin", &tx, &ty) == 2 &&
+            tx < this->config.tilesX && ty < this->config.tilesY &&
+            name == std::filesystem::path(tilePath(keyOf(tx, ty))).filename().string()) {
+            known.insert(keyOf(tx, ty));
+        }
+    }
+}
+
+TiledWorld::~TiledWorld() {
+    flush();
+}
+
+std::string TiledWorld::tilePath(uint64_t key) const {
+    const std::string name = "tile_" + std::to_string(key % config.tilesX) + "_" +
+                             std::to_string(key / config.tilesX) + ".bin";
+    return (std::filesystem::path(config.directory) / name).string();
+}
+
+MapBounds TiledWorld::tileBounds(uint64_t key) const {
+    const double minX = (double)(key % config.tilesX) * config.tileSize;
+    const double minY = (double)(key / config.tilesX) * config.tileSize;
+    return {minX, minY, minX + config.tileSize, minY + config.tileSize};
+}
+
+MapBounds TiledWorld::getBounds() const {
+    return {0, 0, (double)config.tilesX * config.tileSize, (double)config.tilesY * config.tileSize};
+}
+
+TiledWorld::Tile& TiledWorld::acquire(uint64_t key) {
+    auto found = resident.find(key);
+    if (found != resident.end()) {
+        lru.splice(lru.begin(), lru, found->second->recent);
+        return *found->second;
+    }
+
+    auto tile = std::make_unique<Tile>();
+    if (known.count(key) != 0) {
+        MappedFile file;
+        std::string error;
+        if (!file.open(tilePath(key)) || !WorldSnapshot::load(file.view(), tile->store, &error)) {
+            // Плитка остаётся пустой и не перезаписывается, чтобы не потерять файл
+            tile->broken = true;
+            lastError = tilePath(key) + (error.empty() ? ": не удалось открыть" : ": " + error);
+        }
+        ++loads;
+    }
+    lru.push_front(key);
+    tile->recent = lru.begin();
+    return *resident.emplace(key, std::move(tile)).first->second;
+}
+
+bool TiledWorld::saveTile(uint64_t key, Tile& tile) {
+    if (tile.broken) {
+        return true;
+    }
+    const std::string path = tilePath(key);
+    const std::vector<uint8_t>& alive = tile.store.aliveData();
+    std::error_code code;
+    if (std::find(alive.begin(), alive.end(), 1) == alive.end()) {
+        // Снимок без живых не нужен
+        std::filesystem::remove(path, code);
+        known.erase(key);
+    } else {
+        // Как в журнале: новый файл подменяет старый одним переименованием
+        const std::string tmp = path + ".tmp";
+        if (!WorldSnapshot::save(tile.store, tmp)) {
+            return false;
+        }
+        std::filesystem::rename(tmp, path, code);
+        if (code) {
+            return false;
+        }
+    }
+    tile.dirty = false;
+    return true;
+}
+
+size_t TiledWorld::getResidentBytes() const {
+    size_t bytes = 0;
+    for (const auto& entry : resident) {
+        bytes += entry.second->store.size() * BYTES_PER_NPC;
+    }
+    return bytes;
+}
+
+void TiledWorld::evictOverBudget() {
+    size_t bytes = getResidentBytes();
+    auto it = lru.end();
+    while (bytes > config.memoryBudget && it != lru.begin()) {
+        --it;
+        Tile& tile = *resident[*it];
+        // Закреплённые и несохранившиеся плитки остаются в памяти
+        if (tile.pins > 0 || (tile.dirty && !saveTile(*it, tile))) {
+            continue;
+        }
+        bytes -= tile.store.size() * BYTES_PER_NPC;
+        resident.erase(*it);
+        it = lru.erase(it);
+        ++evictions;
+    }
+}
+
+bool TiledWorld::tileRange(const MapBounds& area, size_t& tx0, size_t& ty0, size_t& tx1, size_t& ty1) const {
+    const MapBounds world = getBounds();
+    if (!(area.minX <= area.maxX && area.minY <= area.maxY && area.maxX >= 0 && area.maxY >= 0 &&
+          area.minX <= world.maxX && area.minY <= world.maxY)) {
+        return false;
+    }
+    auto tileOf = [&](double value, size_t tiles) {
+        double t = value / config.tileSize;
+        return t > 0 ? std::min((size_t)t, tiles - 1) : (size_t)0;
+    };
+    tx0 = tileOf(area.minX, config.tilesX);
+    ty0 = tileOf(area.minY, config.tilesY);
+    tx1 = tileOf(area.maxX, config.tilesX);
+    ty1 = tileOf(area.maxY, config.tilesY);
+    return true;
+}
+
+bool TiledWorld::addNPC(NPCType type, std::string_view name, double x, double y) {
+    const MapBounds world = getBounds();
+    if (!(x >= 0 && x <= world.maxX && y >= 0 && y <= world.maxY)) {
+        return false;
+    }
+    size_t tx, ty;
+    tileRange({x, y, x, y}, tx, ty, tx, ty);
+    const uint64_t key = keyOf(tx, ty);
+    Tile& tile = acquire(key);
+    if (tile.broken || tile.store.containsName(name)) {
+        return false;
+    }
+    tile.store.add(type, name, x, y);
+    tile.dirty = true;
+    known.insert(key);
+    evictOverBudget();
+    return true;
+}
+
+bool TiledWorld::startBattle(double range, BattleVisitor& visitor) {
+    if (range > config.tileSize) {
+        return false;
+    }
+    // Отрицательный радиус (или NaN) не допускает ни одной пары
+    if (range >= 0) {
+        const bool notify = visitor.hasObservers();
+        const double rangeSq = range * range;
+        // Копия: сохранение плитки без живых убирает её из known
+        const std::vector<uint64_t> order(known.begin(), known.end());
+
+        std::vector<double> haloX, haloY;
+        std::vector<uint64_t> haloRef;  // Для NPC соседей: (номер соседа << 32) | индекс
+        std::vector<uint64_t> targets;
+        std::vector<uint64_t> mask;
+        for (uint64_t key : order) {
+            // tiles[0] — сама плитка, tiles[1..4] — соседи после неё
+            Tile* tiles[5] = {&acquire(key), nullptr, nullptr, nullptr, nullptr};
+            const size_t tx = key % config.tilesX;
+            const size_t ty = key / config.tilesX;
+            for (size_t s = 0; s < 4; ++s) {
+                size_t nx = tx + LATER_NEIGHBOURS[s][0];
+                size_t ny = ty + LATER_NEIGHBOURS[s][1];
+                if (nx < config.tilesX && ny < config.tilesY && known.count(keyOf(nx, ny)) != 0) {
+                    tiles[s + 1] = &acquire(keyOf(nx, ny));
+                }
+            }
+            for (Tile* tile : tiles) {
+                if (tile) {
+                    ++tile->pins;
+                }
+            }
+
+            // Сетка по плитке с полосой шириной range: свои NPC и живые NPC соседей у границы.
+            // Соседи раньше по порядку уже провели свои бои с этой плиткой.
+            NPCStore& own = tiles[0]->store;
+            const size_t ownCount = own.size();
+            const MapBounds bounds = tileBounds(key);
+            const MapBounds halo{bounds.minX - range, bounds.minY - range,
+                                 bounds.maxX + range, bounds.maxY + range};
+            haloX = own.xData();
+            haloY = own.yData();
+            haloRef.clear();
+            for (size_t s = 1; s < 5; ++s) {
+                if (!tiles[s]) {
+                    continue;
+                }
+                const NPCStore& other = tiles[s]->store;
+                for (size_t j = 0; j < other.size(); ++j) {
+                    if (other.isAlive(j) && other.x(j) >= halo.minX && other.x(j) <= halo.maxX &&
+                        other.y(j) >= halo.minY && other.y(j) <= halo.maxY) {
+                        haloX.push_back(other.x(j));
+                        haloY.push_back(other.y(j));
+                        haloRef.push_back(((uint64_t)s << 32) | j);
+                    }
+                }
+            }
+            SpatialGrid grid(halo, range);
+            grid.build(haloX, haloY);
+
+            // Противники NPC i: свои j > i и все NPC соседей; ключ (сосед, индекс)
+            // упорядочивает их так же, как полный перебор по плиткам
+            const std::vector<NPCType>& types = own.typeData();
+            for (size_t i = 0; i < ownCount; ++i) {
+                if (!canAttack(types[i]) || !own.isAlive(i)) {
+                    continue;
+                }
+                const BattleOutcome* outcomes = BATTLE_OUTCOMES[static_cast<size_t>(types[i])];
+                targets.clear();
+                grid.forEachNeighbourBlock(own.x(i), own.y(i),
+                    [&](const size_t* indices, const double* bx, const double* by, size_t count) {
+                        mask.resize(rangeMaskWords(count));
+                        rangeMask(own.x(i), own.y(i), bx, by, count, rangeSq, mask.data());
+                        for (size_t w = 0; w < mask.size(); ++w) {
+                            for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+                                size_t e = indices[w * 64 + __builtin_ctzll(bits)];
+                                uint64_t ref = e < ownCount ? e : haloRef[e - ownCount];
+                                const NPCStore& other = tiles[ref >> 32]->store;
+                                if ((e >= ownCount || e > i) &&
+                                    outcomes[static_cast<size_t>(other.type(ref & 0xffffffffu))] !=
+                                        BattleOutcome::None) {
+                                    targets.push_back(ref);
+                                }
+                            }
+                        }
+                    });
+                std::sort(targets.begin(), targets.end());
+
+                for (uint64_t ref : targets) {
+                    if (!own.isAlive(i)) {
+                        break;
+                    }
+                    Tile& target = *tiles[ref >> 32];
+                    const size_t j = (size_t)(ref & 0xffffffffu);
+                    BattleOutcome outcome = battleOutcome(types[i], target.store.type(j));
+                    bool fought = &target == tiles[0] ? own.applyOutcome(i, j, outcome)
+                                                      : applyAcross(own, i, target.store, j, outcome);
+                    if (fought) {
+                        tiles[0]->dirty = true;
+                        target.dirty = true;
+                        // Внутри плитки событие ссылается на её таблицу имён;
+                        // для пары через границу имена копируются в посетителя
+                        // (без ожидания очереди асинхронной доставки)
+                        if (notify && &target == tiles[0]) {
+                            visitor.notifyFight(own, i, j, outcome);
+                        } else if (notify) {
+                            visitor.notifyFight(own, i, target.store, j, outcome);
+                        }
+                    }
+                }
+            }
+
+            // Плитка больше не участвует в этом бою; соседи понадобятся дальше
+            for (Tile* tile : tiles) {
+                if (tile) {
+                    --tile->pins;
+                }
+            }
+            // События в очереди читают имена из таблиц плиток: до выгрузки они доставляются
+            if (notify && getResidentBytes() > config.memoryBudget) {
+                visitor.drain();
+            }
+            evictOverBudget();
+        }
+    }
+    visitor.drain();
+    visitor.notifyBattleEnd();
+    return true;
+}
+
+void TiledWorld::removeDeadNPCs() {
+    for (auto& entry : resident) {
+        entry.second->store.removeDead();
+    }
+}
+
+bool TiledWorld::flush() {
+    bool ok = true;
+    for (auto& entry : resident) {
+        if (entry.second->dirty) {
+            ok = saveTile(entry.first, *entry.second) && ok;
+        }
+    }
+    return ok;
+}
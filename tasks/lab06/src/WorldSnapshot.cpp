@@ -0,0 +1,287 @@
+#include "WorldSnapshot.h"
+#include "NPCTypes.h"
+#include "NPCFactory.h"
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace {
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+template <typename T>
+void put(std::vector<char>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+void putBytes(std::vector<char>& out, const void* data, size_t size) {
+    size_t at = out.size();
+    out.resize(at + size);
+    if (size > 0) {
+        std::memcpy(out.data() + at, data, size);
+    }
+}
+
+void padTo8(std::vector<char>& out) {
+    out.resize((out.size() + 7) / 8 * 8, 0);
+}
+
+// Последовательное чтение с проверкой границ
+class Reader {
+private:
+    std::string_view data;
+    size_t pos = 0;
+    bool valid = true;
+
+public:
+    explicit Reader(std::string_view data) : data(data) {}
+
+    const char* take(size_t size) {
+        if (!valid || size > data.size() - pos) {
+            valid = false;
+            return nullptr;
+        }
+        const char* p = data.data() + pos;
+        pos += size;
+        return p;
+    }
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (const char* p = take(sizeof(T))) {
+            std::memcpy(&value, p, sizeof(T));
+        }
+        return value;
+    }
+
+    void alignTo8() {
+        take((8 - pos % 8) % 8);
+    }
+
+    bool ok() const { return valid; }
+    size_t offset() const { return pos; }
+};
+
+bool fail(std::string* error, const char* message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool WorldSnapshot::isSnapshot(std::string_view data) {
+    return data.size() >= sizeof(MAGIC) && std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+uint64_t WorldSnapshot::checksum(const char* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t k = 0;
+    for (; k + 8 <= size; k += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + k, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; k < size; ++k) {
+        hash = (hash ^ (unsigned char)data[k]) * 0x100000001b3ull;
+    }
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool WorldSnapshot::save(const NPCStore& store, const std::string& filename) {
+    if (!hostIsLittleEndian()) {
+        return false;
+    }
+
+    std::vector<size_t> order;
+    size_t namesSize = 0;
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.isAlive(i)) {
+            order.push_back(i);
+            namesSize += store.name(i).size();
+        }
+    }
+    if (namesSize > UINT32_MAX) {
+        return false;
+    }
+    const uint64_t count = order.size();
+
+    // Весь снимок собирается в одном буфере и пишется одним вызовом
+    std::vector<char> out;
+    out.reserve(64 + 8 * NPC_TYPE_COUNT + namesSize + count * (4 + 1 + 16) + 16);
+
+    putBytes(out, MAGIC, sizeof(MAGIC));
+    put<uint32_t>(out, VERSION);
+    put<uint64_t>(out, count);
+
+    put<uint32_t>(out, (uint32_t)NPC_TYPE_COUNT);
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        std::string_view name = npcTypeName(static_cast<NPCType>(t));
+        put<uint8_t>(out, (uint8_t)name.size());
+        putBytes(out, name.data(), name.size());
+    }
+
+    put<uint64_t>(out, namesSize);
+    for (size_t i : order) {
+        putBytes(out, store.name(i).data(), store.name(i).size());
+    }
+    uint32_t offset = 0;
+    put<uint32_t>(out, offset);
+    for (size_t i : order) {
+        offset += (uint32_t)store.name(i).size();
+        put<uint32_t>(out, offset);
+    }
+
+    for (size_t i : order) {
+        put<uint8_t>(out, static_cast<uint8_t>(store.type(i)));
+    }
+    padTo8(out);
+    for (size_t i : order) {
+        put<double>(out, store.x(i));
+    }
+    for (size_t i : order) {
+        put<double>(out, store.y(i));
+    }
+    put<uint64_t>(out, checksum(out.data(), out.size()));
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(out.data(), (std::streamsize)out.size());
+    // Ошибка последнего сброса буфера видна только после close
+    file.close();
+    return (bool)file;
+}
+
+bool WorldSnapshot::load(std::string_view data, NPCStore& store, std::string* error, size_t* record) {
+    if (record) {
+        *record = 0;
+    }
+    if (!hostIsLittleEndian()) {
+        return fail(error, "снимок поддерживается только на little-endian");
+    }
+    if (!isSnapshot(data)) {
+        return fail(error, "нет сигнатуры снимка");
+    }
+    if (data.size() < sizeof(MAGIC) + 8) {
+        return fail(error, "снимок обрезан");
+    }
+
+    // Контрольная сумма проверяется до разбора полей
+    uint64_t stored;
+    std::memcpy(&stored, data.data() + data.size() - 8, 8);
+    if (checksum(data.data(), data.size() - 8) != stored) {
+        return fail(error, "контрольная сумма не совпадает");
+    }
+
+    Reader in(data.substr(0, data.size() - 8));
+    in.take(sizeof(MAGIC));
+    if (in.get<uint32_t>() != VERSION) {
+        return fail(error, "неподдерживаемая версия снимка");
+    }
+    const uint64_t count = in.get<uint64_t>();
+
+    // Таблица типов файла -> теги типов
+    uint32_t typeCount = in.get<uint32_t>();
+    if (!in.ok() || typeCount > 255) {
+        return fail(error, "повреждена таблица типов");
+    }
+    std::vector<NPCType> typeMap(typeCount);
+    for (uint32_t t = 0; t < typeCount; ++t) {
+        uint8_t length = in.get<uint8_t>();
+        const char* name = in.take(length);
+        if (!name || !NPCFactory::parseType(std::string_view(name, length), typeMap[t])) {
+            return fail(error, "неизвестный тип в таблице типов");
+        }
+    }
+
+    const uint64_t namesSize = in.get<uint64_t>();
+    const char* names = in.take(namesSize);
+    if (!in.ok() || count > data.size()) {
+        return fail(error, "повреждена таблица строк");
+    }
+    const char* offsets = in.take((count + 1) * 4);
+    const char* typeCodes = in.take(count);
+    in.alignTo8();
+    const char* xs = in.take(count * 8);
+    const char* ys = in.take(count * 8);
+    if (!in.ok() || in.offset() != data.size() - 8) {
+        return fail(error, "размер снимка не совпадает с заголовком");
+    }
+
+    // Проверка смещений и типов до изменения хранилища
+    uint32_t previous = 0;
+    for (uint64_t i = 0; i <= count; ++i) {
+        uint32_t offset;
+        std::memcpy(&offset, offsets + i * 4, 4);
+        if ((i == 0 && offset != 0) || offset < previous || offset > namesSize) {
+            return fail(error, "повреждены смещения имён");
+        }
+        previous = offset;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        if ((unsigned char)typeCodes[i] >= typeCount) {
+            return fail(error, "повреждён массив типов");
+        }
+    }
+
+    auto nameOf = [&](uint64_t i) {
+        uint32_t begin, end;
+        std::memcpy(&begin, offsets + i * 4, 4);
+        std::memcpy(&end, offsets + (i + 1) * 4, 4);
+        return std::string_view(names + begin, end - begin);
+    };
+    // Пустые и повторные имена save не пишет: такой снимок отвергается,
+    // как строки с ними в текстовом формате. Повторы ищутся по открытой
+    // хеш-таблице номеров записей (0 — пусто), без выделения памяти на имя.
+    size_t buckets = 16;
+    while (buckets < count * 2) {
+        buckets *= 2;
+    }
+    std::vector<uint32_t> seen(buckets, 0);
+    std::hash<std::string_view> hasher;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string_view name = nameOf(i);
+        const char* problem = name.empty() ? "пустое имя" : nullptr;
+        for (size_t b = hasher(name) & (buckets - 1); !problem; b = (b + 1) & (buckets - 1)) {
+            if (seen[b] == 0) {
+                seen[b] = (uint32_t)i + 1;
+                break;
+            }
+            if (nameOf(seen[b] - 1) == name) {
+                problem = "имя уже занято";
+            }
+        }
+        if (problem) {
+            if (record) {
+                *record = (size_t)i + 1;
+            }
+            return fail(error, problem);
+        }
+    }
+
+    // Поля копируются как есть, без разбора записей
+    store.clear();
+    store.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        double x, y;
+        std::memcpy(&x, xs + i * 8, 8);
+        std::memcpy(&y, ys + i * 8, 8);
+        store.add(typeMap[(unsigned char)typeCodes[i]], nameOf(i), x, y);
+    }
+    return true;
+}
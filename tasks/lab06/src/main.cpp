@@ -3,6 +3,8 @@
 #include "Editor.h"
 #include "NPCFactory.h"
 #include "Observer.h"
+#include "BattleStats.h"
+#include "BatchRunner.h"
 
 void showMenu() {
     std::cout << "\n=== Balagur Fate 3 — Редактор подземелья ===" << std::endl;
@@ -16,7 +18,28 @@ void showMenu() {
     std::cout << "Ваш выбор: ";
 }
 
-int main() {
+// Пакетный режим: сценарии из аргументов командной строки
+int runBatch(int argc, char** argv) {
+    std::string_view first = argv[1];
+    if (first == "--help" || first == "-h") {
+        BatchRunner::printUsage(std::cout);
+        return 0;
+    }
+    BatchOptions options;
+    std::string error;
+    if (!BatchRunner::parseArguments(argc, argv, options, error)) {
+        std::cerr << "Ошибка: " << error << "\n";
+        BatchRunner::printUsage(std::cerr);
+        return 2;
+    }
+    return BatchRunner::run(options, std::cout, std::cerr) == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return runBatch(argc, argv);
+    }
+    
     Editor editor;
     BattleVisitor visitor;
     
@@ -74,7 +97,11 @@ int main() {
                 std::string filename;
                 std::cout << "Введите имя файла: ";
                 std::cin >> filename;
-                if (editor.loadFromFile(filename)) {
+                std::vector<LoadError> errors;
+                if (editor.loadFromFile(filename, &errors)) {
+                    for (const auto& error : errors) {
+                        std::cout << "Строка " << error.line << ": " << error.message << std::endl;
+                    }
                     std::cout << "Загружено успешно!" << std::endl;
                 } else {
                     std::cout << "Ошибка загрузки." << std::endl;
@@ -87,8 +114,10 @@ int main() {
                 std::cout << "Введите радиус боя: ";
                 std::cin >> range;
                 std::cout << "\nБой начался..." << std::endl;
-                editor.startBattle(range, visitor);
+                BattleStats stats;
+                editor.startBattle(range, visitor, &stats);
                 std::cout << "Бой завершён!" << std::endl;
+                stats.print(std::cout);
                 break;
             }
             
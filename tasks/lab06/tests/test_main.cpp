@@ -9,6 +9,105 @@
 #include "BattleVisitor.h"
 #include "Observer.h"
 #include "Editor.h"
+#include "NPCStore.h"
+#include "NPCPool.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include "SpatialGrid.h"
+#include "RangeKernel.h"
+#include "WorldSnapshot.h"
+#include "KillEventPipeline.h"
+#include "ThreadPool.h"
+#include "BattleStats.h"
+#include "BattleEngine.h"
+#include "BatchRunner.h"
+#include "DynamicGrid.h"
+#include "Simulation.h"
+#include "Journal.h"
+#include "NPCTypes.h"
+#include "TiledWorld.h"
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <set>
+#include <filesystem>
+#include <cmath>
+
+// Подсчёт выделений памяти для тестов арены
+static std::atomic<size_t> allocationCount{0};
+static std::atomic<size_t> releaseCount{0};
+
+// Все обычные формы new/delete заменены одной парой malloc/free,
+// чтобы выделение и освобождение всегда совпадали
+static void* countedAllocate(size_t size) noexcept {
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+
+static void countedRelease(void* p) noexcept {
+    if (p) {
+        ++releaseCount;
+    }
+    std::free(p);
+}
+
+void* operator new(size_t size) {
+    if (void* p = countedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* p = countedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    countedRelease(p);
+}
+
+void operator delete[](void* p) noexcept {
+    countedRelease(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    countedRelease(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    countedRelease(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+
+// Событие убийства с именами из таблицы names
+static KillEvent makeKillEvent(NameTable& names, std::string_view killer, std::string_view victim) {
+    return KillEvent{&names, names.intern(killer), names.intern(victim), false};
+}
 
 //
 TEST(NPCTest, DragonCreation) {
@@ -327,8 +426,9 @@ TEST(EditorTest, GetNPCInvalidIndex) {
 
 // Тесты для Observer
 TEST(ObserverTest, FileObserverCreation) {
+    NameTable names;
     FileObserver observer("test_observer.log");
-    observer.onKill("Attacker", "Victim");
+    observer.onKill(makeKillEvent(names, "Attacker", "Victim"));
     
     std::ifstream file("test_observer.log");
     EXPECT_TRUE(file.is_open());
@@ -373,6 +473,2083 @@ TEST(NPCTest, ToStringFormat) {
     EXPECT_NE(str.find("TestDragon"), std::string::npos);
 }
 
+// Тесты для пространственной сетки
+TEST(SpatialGridTest, NeighboursCoverRange) {
+    std::vector<double> xs = {0, 10, 30, 499, 250};
+    std::vector<double> ys = {0, 10, 30, 499, 250};
+    SpatialGrid grid(0, 0, 500, 500, 20.0);
+    grid.build(xs, ys);
+
+    std::vector<size_t> found;
+    grid.forEachNeighbour(0, 0, [&](size_t j) { found.push_back(j); });
+    EXPECT_NE(std::find(found.begin(), found.end(), 0), found.end());
+    EXPECT_NE(std::find(found.begin(), found.end(), 1), found.end());
+    EXPECT_EQ(std::find(found.begin(), found.end(), 3), found.end());
+}
+
+TEST(SpatialGridTest, OutOfMapPointsAreClamped) {
+    std::vector<double> xs = {-50, 600};
+    std::vector<double> ys = {-50, 600};
+    SpatialGrid grid(0, 0, 500, 500, 10.0);
+    grid.build(xs, ys);
+
+    size_t count = 0;
+    grid.forEachNeighbour(-40, -40, [&](size_t) { ++count; });
+    EXPECT_EQ(count, 1);
+}
+
+// Наблюдатель, запоминающий события для сравнения порядка убийств
+class RecordingObserver : public BattleObserver {
+public:
+    std::vector<std::string> events;
+    void onKill(const KillEvent& event) override {
+        std::string text(event.killerName());
+        if (event.mutual) {
+            text += " и ";
+            text += event.victimName();
+            text += ">друг друга";
+        } else {
+            text += ">";
+            text += event.victimName();
+        }
+        events.push_back(text);
+    }
+};
+
+static std::shared_ptr<NPC> makeRandomNPC(std::mt19937& rng, size_t index) {
+    static const char* types[] = {"Dragon", "Bull", "Frog"};
+    std::uniform_real_distribution<double> coord(0, 500);
+    std::uniform_int_distribution<int> type(0, 2);
+    return NPCFactory::createNPC(types[type(rng)], "N" + std::to_string(index),
+                                 coord(rng), coord(rng));
+}
+
+TEST(BattleTest, GridBattleMatchesFullPairScan) {
+    for (double range : {0.0, 3.0, 17.5, 120.0, 800.0}) {
+        std::mt19937 rng(42);
+        Editor editor;
+        std::vector<std::shared_ptr<NPC>> reference;
+        for (size_t i = 0; i < 600; ++i) {
+            auto npc = makeRandomNPC(rng, i);
+            editor.addNPC(npc);
+            reference.push_back(NPCFactory::createNPC(npc->getType(), npc->getName(),
+                                                      npc->getX(), npc->getY()));
+        }
+
+        auto gridLog = std::make_shared<RecordingObserver>();
+        BattleVisitor gridVisitor;
+        gridVisitor.addObserver(gridLog);
+        editor.startBattle(range, gridVisitor);
+
+        // Эталон: полный перебор пар (i, j)
+        auto fullLog = std::make_shared<RecordingObserver>();
+        BattleVisitor fullVisitor;
+        fullVisitor.addObserver(fullLog);
+        for (size_t i = 0; i < reference.size(); ++i) {
+            for (size_t j = i + 1; j < reference.size(); ++j) {
+                if (reference[i]->isAlive() && reference[j]->isAlive() &&
+                    reference[i]->distanceTo(*reference[j]) <= range) {
+                    reference[i]->accept(fullVisitor, *reference[j]);
+                }
+            }
+        }
+
+        EXPECT_EQ(gridLog->events, fullLog->events) << "range " << range;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            EXPECT_EQ(editor.getNPC(i)->isAlive(), reference[i]->isAlive());
+        }
+    }
+}
+
+TEST(BattleTest, NegativeRangeNoFights) {
+    Editor editor;
+    editor.addNPC(std::make_shared<Dragon>("D", 0, 0));
+    editor.addNPC(std::make_shared<Bull>("B", 0, 0));
+
+    BattleVisitor visitor;
+    editor.startBattle(-1.0, visitor);
+    editor.removeDeadNPCs();
+
+    EXPECT_EQ(editor.getNPCCount(), 2);
+}
+
+// Тесты для пакетной проверки дальности
+TEST(RangeKernelTest, MatchesScalarReference) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coord(0, 100);
+    for (size_t count : {0, 1, 3, 4, 63, 64, 65, 130}) {
+        std::vector<double> xs(count), ys(count);
+        for (size_t k = 0; k < count; ++k) {
+            xs[k] = coord(rng);
+            ys[k] = coord(rng);
+        }
+        std::vector<uint64_t> fast(rangeMaskWords(count) + 1, ~uint64_t(0));
+        std::vector<uint64_t> slow(rangeMaskWords(count) + 1, ~uint64_t(0));
+        rangeMask(50, 50, xs.data(), ys.data(), count, 30.0 * 30.0, fast.data());
+        rangeMaskScalar(50, 50, xs.data(), ys.data(), count, 30.0 * 30.0, slow.data());
+        EXPECT_EQ(fast, slow) << rangeMaskBackend() << ", count " << count;
+    }
+}
+
+TEST(RangeKernelTest, BoundaryIsInclusive) {
+    double xs[] = {3, 3, 0};
+    double ys[] = {4, 4.001, 0};
+    uint64_t mask = 0;
+    rangeMask(0, 0, xs, ys, 3, 5.0 * 5.0, &mask);
+    EXPECT_EQ(mask, 0b101u);
+}
+
+// Тесты для таблицы исходов боя
+TEST(BattleRulesTest, TypeTags) {
+    EXPECT_EQ(Dragon("D", 0, 0).getTypeTag(), NPCType::Dragon);
+    EXPECT_EQ(Bull("B", 0, 0).getTypeTag(), NPCType::Bull);
+    EXPECT_EQ(Frog("F", 0, 0).getTypeTag(), NPCType::Frog);
+}
+
+TEST(BattleRulesTest, OutcomeTable) {
+    EXPECT_EQ(battleOutcome(NPCType::Dragon, NPCType::Bull), BattleOutcome::AttackerKills);
+    EXPECT_EQ(battleOutcome(NPCType::Bull, NPCType::Frog), BattleOutcome::AttackerKills);
+    EXPECT_EQ(battleOutcome(NPCType::Dragon, NPCType::Dragon), BattleOutcome::MutualKill);
+    EXPECT_EQ(battleOutcome(NPCType::Bull, NPCType::Bull), BattleOutcome::MutualKill);
+    EXPECT_EQ(battleOutcome(NPCType::Bull, NPCType::Dragon), BattleOutcome::None);
+    EXPECT_EQ(battleOutcome(NPCType::Frog, NPCType::Frog), BattleOutcome::None);
+    EXPECT_TRUE(canAttack(NPCType::Dragon));
+    EXPECT_TRUE(canAttack(NPCType::Bull));
+    EXPECT_FALSE(canAttack(NPCType::Frog));
+}
+
+TEST(BattleRulesTest, FightNotifiesObservers) {
+    Dragon d1("D1", 0, 0);
+    Dragon d2("D2", 0, 0);
+    auto log = std::make_shared<RecordingObserver>();
+    BattleVisitor visitor;
+    visitor.addObserver(log);
+
+    visitor.fight(d1, d2);
+    visitor.fight(d1, d2);  // Мёртвые больше не сражаются
+
+    ASSERT_EQ(log->events.size(), 1);
+    EXPECT_EQ(log->events[0], "D1 и D2>друг друга");
+}
+
+// Тесты для хранилища NPC
+TEST(NPCStoreTest, AddByFields) {
+    NPCStore store;
+    store.add(NPCType::Bull, "B", 10, 20);
+    ASSERT_EQ(store.size(), 1);
+    EXPECT_EQ(store.type(0), NPCType::Bull);
+    EXPECT_EQ(store.name(0), "B");
+    EXPECT_EQ(store.x(0), 10);
+    EXPECT_EQ(store.y(0), 20);
+    EXPECT_TRUE(store.isAlive(0));
+}
+
+TEST(NPCStoreTest, ViewIsStableAndLinked) {
+    NPCStore store;
+    store.add(NPCType::Dragon, "D", 1, 2);
+    auto view = store.view(0);
+    EXPECT_EQ(view, store.view(0));
+    EXPECT_EQ(view->getName(), "D");
+
+    view->kill();
+    EXPECT_FALSE(store.isAlive(0));
+
+    store.add(NPCType::Bull, "B", 1, 2);
+    store.kill(1);
+    EXPECT_FALSE(store.view(1)->isAlive());
+}
+
+TEST(NPCStoreTest, RemoveDeadMovesLastAndKeepsLinks) {
+    NPCStore store;
+    store.add(NPCType::Dragon, "A", 0, 0);
+    store.add(NPCType::Bull, "B", 0, 0);
+    store.add(NPCType::Frog, "C", 0, 0);
+    auto c = store.view(2);
+    store.kill(0);
+    store.removeDead();
+
+    // Последняя запись переносится на место погибшей
+    ASSERT_EQ(store.size(), 2);
+    EXPECT_EQ(store.name(0), "C");
+    EXPECT_EQ(store.name(1), "B");
+    c->kill();
+    EXPECT_FALSE(store.isAlive(0));
+    EXPECT_TRUE(store.isAlive(1));
+
+    // Освободившееся имя используется повторно
+    store.add(NPCType::Frog, "E", 0, 0);
+    EXPECT_EQ(store.name(2), "E");
+}
+
+TEST(NPCStoreTest, ObjectOutlivesEditor) {
+    auto npc = std::make_shared<Dragon>("D", 10, 10);
+    {
+        Editor editor;
+        editor.addNPC(npc);
+    }
+    npc->kill();  // Связь с уничтоженным хранилищем разорвана
+    EXPECT_FALSE(npc->isAlive());
+}
+
+TEST(EditorTest, BattleKillsVisibleThroughAddedObjects) {
+    Editor editor;
+    auto d = std::make_shared<Dragon>("D", 0, 0);
+    auto b = std::make_shared<Bull>("B", 1, 1);
+    editor.addNPC(d);
+    editor.addNPC(b);
+
+    BattleVisitor visitor;
+    editor.startBattle(5.0, visitor);
+
+    EXPECT_TRUE(d->isAlive());
+    EXPECT_FALSE(b->isAlive());
+    EXPECT_FALSE(editor.getNPC(1)->isAlive());
+}
+
+// Тесты для арены NPC
+TEST(NPCPoolTest, CreatesLinkedObjectsOfEachType) {
+    NPCPool pool;
+    auto d = pool.create(NPCType::Dragon, "D", 1, 2);
+    auto b = pool.create(NPCType::Bull, "B", 3, 4);
+    auto f = pool.create(NPCType::Frog, "F", 5, 6);
+    EXPECT_EQ(d->getType(), "Dragon");
+    EXPECT_EQ(b->getType(), "Bull");
+    EXPECT_EQ(f->getName(), "F");
+    EXPECT_EQ(pool.size(), 3);
+
+    // Объекты переживают освобождение пула
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(d->getName(), "D");
+}
+
+TEST(NPCPoolTest, AllocationCountsBeforeAndAfter) {
+    const size_t count = 10000;
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("N" + std::to_string(i));  // Короткие имена без выделений
+    }
+    std::vector<std::shared_ptr<NPC>> objects;
+    objects.reserve(count);
+
+    // До: make_shared на каждый объект
+    size_t before = allocationCount;
+    for (size_t i = 0; i < count; ++i) {
+        objects.push_back(NPCFactory::createNPC(NPCType::Dragon, names[i], 1, 1));
+    }
+    size_t heapAllocations = allocationCount - before;
+    before = releaseCount;
+    objects.clear();
+    size_t heapReleases = releaseCount - before;
+
+    // После: один слаб под все объекты
+    NPCPool pool;
+    before = allocationCount;
+    pool.reserve(NPCType::Dragon, count);
+    for (size_t i = 0; i < count; ++i) {
+        objects.push_back(NPCFactory::createNPC(NPCType::Dragon, names[i], 1, 1, pool));
+    }
+    size_t poolAllocations = allocationCount - before;
+    before = releaseCount;
+    objects.clear();
+    pool.clear();
+    size_t poolReleases = releaseCount - before;
+
+    EXPECT_EQ(heapAllocations, count);
+    EXPECT_EQ(heapReleases, count);
+    EXPECT_LE(poolAllocations, 3);  // Арена, слаб и список слабов
+    EXPECT_LE(poolReleases, 3);
+}
+
+TEST(NPCPoolTest, ReserveUsesRestOfCurrentSlab) {
+    SlabPool<Dragon> pool(64);
+    pool.create("First", 1, 1);
+    // В первом слабе осталось 63 места: новый слаб — только на недостающие 37
+    pool.reserve(100);
+    EXPECT_EQ(pool.slabCount(), 2u);
+    EXPECT_EQ(pool.capacity(), 101u);
+    for (int i = 0; i < 100; ++i) {
+        pool.create("D" + std::to_string(i), 1, 1);
+    }
+    EXPECT_EQ(pool.size(), 101u);
+    EXPECT_EQ(pool.capacity(), 101u);
+
+    // Повторные резервы без создания не выделяют память
+    pool.reserve(10);
+    pool.reserve(10);
+    EXPECT_EQ(pool.capacity(), 111u);
+}
+
+TEST(EditorTest, ViewsComeFromEditorArena) {
+    Editor editor;
+    for (int i = 0; i < 1000; ++i) {
+        editor.addNPC(NPCFactory::createNPC(NPCType::Frog, "F" + std::to_string(i), 1, 1));
+    }
+    editor.removeDeadNPCs();
+    std::ofstream("test_pool.txt") << "Dragon A 1 1\nBull B 2 2\nFrog C 3 3\n";
+    ASSERT_TRUE(editor.loadFromFile("test_pool.txt"));
+
+    size_t before = allocationCount;
+    for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+        ASSERT_NE(editor.getNPC(i), nullptr);
+    }
+    EXPECT_LE(allocationCount - before, 7);  // Арена, по слабу и списку слабов на тип
+
+    auto kept = editor.getNPC(0);
+    editor.clear();
+    EXPECT_EQ(kept->getName(), "A");
+    EXPECT_EQ(editor.getNPCCount(), 0);
+}
+
+// Тесты для индекса имён
+TEST(EditorTest, NameIndexFollowsRemovalAndClear) {
+    Editor editor;
+    auto d = std::make_shared<Dragon>("D", 100, 100);
+    editor.addNPC(d);
+    editor.addNPC(std::make_shared<Bull>("B", 200, 200));
+    EXPECT_FALSE(editor.isNameUnique("D"));
+
+    d->kill();
+    EXPECT_FALSE(editor.isNameUnique("D"));  // Мёртвый ещё на карте
+    editor.removeDeadNPCs();
+    EXPECT_TRUE(editor.isNameUnique("D"));
+    EXPECT_TRUE(editor.addNPC(std::make_shared<Frog>("D", 1, 1)));
+
+    editor.clear();
+    EXPECT_TRUE(editor.isNameUnique("B"));
+}
+
+TEST(EditorTest, LoadSkipsDuplicateNames) {
+    std::ofstream("test_duplicates.txt") << "Dragon Same 1 1\nBull Same 2 2\nFrog Other 3 3\n";
+    Editor editor;
+    ASSERT_TRUE(editor.loadFromFile("test_duplicates.txt"));
+    ASSERT_EQ(editor.getNPCCount(), 2);
+    EXPECT_EQ(editor.getNPC(0)->getType(), "Dragon");
+    EXPECT_FALSE(editor.isNameUnique("Other"));
+}
+
+TEST(EditorTest, NameLookupDoesNotAllocate) {
+    Editor editor;
+    for (int i = 0; i < 100; ++i) {
+        editor.addNPC(std::make_shared<Frog>("VeryLongFrogNameNumber" + std::to_string(i), 1, 1));
+    }
+    std::string probe = "VeryLongFrogNameNumber42";
+
+    size_t before = allocationCount;
+    bool unique = editor.isNameUnique(probe);
+    EXPECT_EQ(allocationCount - before, 0);
+    EXPECT_FALSE(unique);
+}
+
+// Тесты для разбора текстового формата на месте
+TEST(FactoryTest, ParseRecordAcceptsStreamSyntax) {
+    NPCRecord record;
+    ASSERT_TRUE(NPCFactory::parseRecord("  Bull\tB1   +12.5 -3e1 extra\r", record));
+    EXPECT_EQ(record.type, NPCType::Bull);
+    EXPECT_EQ(record.name, "B1");
+    EXPECT_DOUBLE_EQ(record.x, 12.5);
+    EXPECT_DOUBLE_EQ(record.y, -30.0);
+}
+
+TEST(FactoryTest, ParseRecordReportsReason) {
+    NPCRecord record;
+    const char* error = nullptr;
+    EXPECT_FALSE(NPCFactory::parseRecord("Dragon OnlyName", record, &error));
+    EXPECT_STREQ(error, "некорректная координата X");
+    EXPECT_FALSE(NPCFactory::parseRecord("Wizard W 1 2", record, &error));
+    EXPECT_STREQ(error, "неизвестный тип NPC");
+    EXPECT_FALSE(NPCFactory::parseRecord("Frog F 1 inf", record, &error));
+    EXPECT_STREQ(error, "некорректная координата Y");
+    EXPECT_FALSE(NPCFactory::parseRecord("Frog F 10abc 2", record, &error));
+}
+
+TEST(EditorTest, LoadReportsMalformedLines) {
+    std::ofstream("test_malformed.txt")
+        << "Dragon D1 1 1\n"
+        << "\n"
+        << "Dragon Broken\n"
+        << "Bull B1 2 2\r\n"
+        << "Elf E 3 3\n"
+        << "Frog F1 4 4";  // Без перевода строки в конце
+    Editor editor;
+    std::vector<LoadError> errors;
+    ASSERT_TRUE(editor.loadFromFile("test_malformed.txt", &errors));
+
+    EXPECT_EQ(editor.getNPCCount(), 3);
+    ASSERT_EQ(errors.size(), 2);
+    EXPECT_EQ(errors[0].line, 3);
+    EXPECT_EQ(errors[1].line, 5);
+    EXPECT_EQ(errors[1].message, "неизвестный тип NPC");
+}
+
+TEST(EditorTest, SavedTextLoadsBack) {
+    Editor editor1;
+    editor1.addNPC(std::make_shared<Dragon>("D1", 100.25, 150));
+    editor1.addNPC(std::make_shared<Frog>("F1", 0, 499.5));
+    ASSERT_TRUE(editor1.saveToFile("test_roundtrip.txt"));
+
+    Editor editor2;
+    std::vector<LoadError> errors;
+    ASSERT_TRUE(editor2.loadFromFile("test_roundtrip.txt", &errors));
+    EXPECT_TRUE(errors.empty());
+    ASSERT_EQ(editor2.getNPCCount(), 2);
+    EXPECT_EQ(editor2.getStore().x(0), 100.25);
+    EXPECT_EQ(editor2.getStore().y(1), 499.5);
+    EXPECT_EQ(editor2.getStore().type(1), NPCType::Frog);
+}
+
+// Тесты для двоичного снимка
+static std::string readWholeFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+static void expectSameWorld(const Editor& a, const Editor& b) {
+    ASSERT_EQ(a.getNPCCount(), b.getNPCCount());
+    for (size_t i = 0; i < a.getNPCCount(); ++i) {
+        EXPECT_EQ(a.getStore().type(i), b.getStore().type(i));
+        EXPECT_EQ(a.getStore().name(i), b.getStore().name(i));
+        EXPECT_EQ(a.getStore().x(i), b.getStore().x(i));
+        EXPECT_EQ(a.getStore().y(i), b.getStore().y(i));
+    }
+}
+
+TEST(SnapshotTest, TextBinaryTextRoundTrip) {
+    std::ofstream("test_world.txt") << "Dragon D1 100 150\nBull B1 200.5 250\nFrog F1 0 500\n";
+    Editor text;
+    ASSERT_TRUE(text.loadFromFile("test_world.txt"));
+
+    ASSERT_TRUE(text.saveToFile("test_world.bin"));
+    EXPECT_TRUE(WorldSnapshot::isSnapshot(readWholeFile("test_world.bin")));
+
+    Editor binary;
+    std::vector<LoadError> errors;
+    ASSERT_TRUE(binary.loadFromFile("test_world.bin", &errors));
+    EXPECT_TRUE(errors.empty());
+    expectSameWorld(text, binary);
+
+    ASSERT_TRUE(binary.saveToFile("test_world_back.txt"));
+    EXPECT_EQ(readWholeFile("test_world_back.txt"), readWholeFile("test_world.txt"));
+}
+
+TEST(SnapshotTest, BinaryKeepsFullPrecisionAndSkipsDead) {
+    Editor editor;
+    auto dead = std::make_shared<Bull>("Dead", 1, 1);
+    editor.addNPC(std::make_shared<Dragon>("D", 123.456789012345, 0.1));
+    editor.addNPC(dead);
+    dead->kill();
+    ASSERT_TRUE(editor.saveToFile("test_precise.dat", SaveFormat::Binary));
+
+    Editor loaded;
+    ASSERT_TRUE(loaded.loadFromFile("test_precise.dat"));
+    ASSERT_EQ(loaded.getNPCCount(), 1);
+    EXPECT_EQ(loaded.getStore().x(0), 123.456789012345);
+    EXPECT_EQ(loaded.getStore().y(0), 0.1);
+}
+
+TEST(SnapshotTest, EmptyWorld) {
+    Editor editor;
+    ASSERT_TRUE(editor.saveToFile("test_empty.bin"));
+    Editor loaded;
+    loaded.addNPC(std::make_shared<Frog>("F", 1, 1));
+    ASSERT_TRUE(loaded.loadFromFile("test_empty.bin"));
+    EXPECT_EQ(loaded.getNPCCount(), 0);
+}
+
+TEST(SnapshotTest, CorruptedSnapshotIsRejected) {
+    Editor editor;
+    editor.addNPC(std::make_shared<Dragon>("D", 10, 10));
+    ASSERT_TRUE(editor.saveToFile("test_corrupt.bin"));
+
+    std::string bytes = readWholeFile("test_corrupt.bin");
+    bytes[bytes.size() / 2] ^= 0x5a;
+    std::ofstream("test_corrupt.bin", std::ios::binary) << bytes;
+
+    Editor loaded;
+    loaded.addNPC(std::make_shared<Frog>("Keep", 1, 1));
+    std::vector<LoadError> errors;
+    EXPECT_FALSE(loaded.loadFromFile("test_corrupt.bin", &errors));
+    ASSERT_EQ(errors.size(), 1);
+    EXPECT_EQ(errors[0].line, 0);
+    EXPECT_EQ(loaded.getNPCCount(), 1);  // Мир не изменился
+}
+
+// Снимок с подменёнными байтами имён и верной контрольной суммой
+static void rewriteSnapshotNames(const std::string& filename, const std::string& from, const std::string& to) {
+    std::string bytes = readWholeFile(filename);
+    size_t at = bytes.find(from);
+    ASSERT_NE(at, std::string::npos);
+    bytes.replace(at, from.size(), to);
+    uint64_t sum = WorldSnapshot::checksum(bytes.data(), bytes.size() - 8);
+    std::memcpy(&bytes[bytes.size() - 8], &sum, 8);
+    std::ofstream(filename, std::ios::binary) << bytes;
+}
+
+TEST(SnapshotTest, DuplicateOrEmptyNameIsRejected) {
+    Editor editor;
+    editor.addNPC(std::make_shared<Dragon>("Aa", 10, 10));
+    editor.addNPC(std::make_shared<Bull>("Ab", 20, 20));
+    ASSERT_TRUE(editor.saveToFile("test_duplicate.bin"));
+    rewriteSnapshotNames("test_duplicate.bin", "AaAb", "AaAa");
+
+    Editor loaded;
+    loaded.addNPC(std::make_shared<Frog>("Keep", 1, 1));
+    std::vector<LoadError> errors;
+    EXPECT_FALSE(loaded.loadFromFile("test_duplicate.bin", &errors));
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_EQ(errors[0].line, 2u);
+    EXPECT_EQ(errors[0].message, "имя уже занято");
+    EXPECT_EQ(loaded.getNPCCount(), 1u);
+
+    // Смещения имён [0, 0, 2]: первая запись без имени
+    ASSERT_TRUE(editor.saveToFile("test_duplicate.bin"));
+    const uint32_t offsets[3] = {0, 2, 4};
+    const uint32_t emptyFirst[3] = {0, 0, 4};
+    rewriteSnapshotNames("test_duplicate.bin", std::string((const char*)offsets, sizeof(offsets)),
+                         std::string((const char*)emptyFirst, sizeof(emptyFirst)));
+    errors.clear();
+    EXPECT_FALSE(loaded.loadFromFile("test_duplicate.bin", &errors));
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_EQ(errors[0].line, 1u);
+    EXPECT_EQ(errors[0].message, "пустое имя");
+    EXPECT_EQ(loaded.getNPCCount(), 1u);
+}
+
+// Тесты для буферизованного FileObserver
+TEST(ObserverTest, FileObserverBuffersUntilBattleEnd) {
+    std::remove("test_buffered.log");
+    NameTable names;
+    FileObserver observer("test_buffered.log");
+    observer.onKill(makeKillEvent(names, "A", "B"));
+    EXPECT_EQ(readWholeFile("test_buffered.log"), "");
+
+    observer.onBattleEnd();
+    EXPECT_EQ(readWholeFile("test_buffered.log"), "[СОБЫТИЕ] A убил B\n");
+}
+
+TEST(ObserverTest, FileObserverFlushesOnThresholdAndDestruction) {
+    std::remove("test_threshold.log");
+    NameTable names;
+    {
+        FileObserver observer("test_threshold.log", 64, FsyncPolicy::OnFlush);
+        for (int i = 0; i < 10; ++i) {
+            observer.onKill(makeKillEvent(names, "Killer" + std::to_string(i), "Victim"));
+        }
+        std::string partial = readWholeFile("test_threshold.log");
+        EXPECT_FALSE(partial.empty());  // Порог превышен — часть уже на диске
+        observer.onKill(makeKillEvent(names, "Last", "One"));
+    }
+    std::string log = readWholeFile("test_threshold.log");
+    EXPECT_EQ(std::count(log.begin(), log.end(), '\n'), 11);
+    EXPECT_NE(log.find("Last убил One"), std::string::npos);
+}
+
+TEST(ObserverTest, StartBattleFlushesFileLog) {
+    std::remove("test_battle.log");
+    auto log = std::make_shared<FileObserver>("test_battle.log");
+    BattleVisitor visitor;
+    visitor.addObserver(log);
+
+    Editor editor;
+    editor.addNPC(std::make_shared<Dragon>("D", 0, 0));
+    editor.addNPC(std::make_shared<Bull>("B", 1, 1));
+    editor.startBattle(5.0, visitor);
+
+    EXPECT_EQ(readWholeFile("test_battle.log"), "[СОБЫТИЕ] D убил B\n");
+}
+
+// Тесты для асинхронной доставки событий
+TEST(AsyncPipelineTest, PreservesOrderWithBlocking) {
+    std::vector<int> received;
+    NameTable names;
+    for (int i = 0; i < 5000; ++i) {
+        names.intern(std::to_string(i));
+    }
+    {
+        KillEventPipeline pipeline(8, Backpressure::Block, [&](const KillEvent& event) {
+            received.push_back(std::stoi(std::string(event.killerName())));
+        });
+        for (int i = 0; i < 5000; ++i) {
+            EXPECT_TRUE(pipeline.push(KillEvent{&names, (NameId)i, (NameId)i, false}));
+        }
+        pipeline.drain();
+        EXPECT_EQ(received.size(), 5000);
+        EXPECT_EQ(pipeline.droppedCount(), 0);
+    }
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_EQ(received[i], i);
+    }
+}
+
+TEST(AsyncPipelineTest, DropPolicyCountsDrops) {
+    std::atomic<bool> release{false};
+    std::atomic<size_t> delivered{0};
+    KillEventPipeline pipeline(4, Backpressure::Drop, [&](const KillEvent&) {
+        while (!release) {
+            std::this_thread::yield();
+        }
+        ++delivered;
+    });
+    size_t accepted = 0;
+    for (int i = 0; i < 100; ++i) {
+        accepted += pipeline.push(KillEvent{}) ? 1 : 0;
+    }
+    release = true;
+    pipeline.drain();
+
+    EXPECT_LE(accepted, 5);  // Ёмкость и одно событие в обработке
+    EXPECT_EQ(pipeline.droppedCount(), 100 - accepted);
+    EXPECT_EQ(delivered, accepted);
+}
+
+TEST(AsyncPipelineTest, SleepingConsumerWakesOnPush) {
+    std::atomic<size_t> delivered{0};
+    KillEventPipeline pipeline(4, Backpressure::Block, [&](const KillEvent&) { ++delivered; });
+    for (int round = 0; round < 3; ++round) {
+        // Пустая очередь: потребитель успевает уснуть
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_TRUE(pipeline.push(KillEvent{}));
+        pipeline.drain();
+        EXPECT_EQ(delivered, (size_t)round + 1);
+    }
+}
+
+TEST(AsyncPipelineTest, StartBattleDrainsBeforeReturn) {
+    Editor editor;
+    for (int i = 0; i < 200; ++i) {
+        editor.addNPC(std::make_shared<Bull>("B" + std::to_string(i), 10 + i % 20, 10 + i / 20));
+    }
+    auto log = std::make_shared<RecordingObserver>();
+    BattleVisitor visitor;
+    visitor.addObserver(log);
+    visitor.enableAsync(16, Backpressure::Block);
+    ASSERT_TRUE(visitor.isAsync());
+
+    editor.startBattle(3.0, visitor);
+    EXPECT_EQ(log->events.size(), 100);  // Быки гибнут парами
+    EXPECT_EQ(visitor.droppedEvents(), 0);
+
+    // Тот же порядок, что и при синхронной доставке
+    Editor reference;
+    for (int i = 0; i < 200; ++i) {
+        reference.addNPC(std::make_shared<Bull>("B" + std::to_string(i), 10 + i % 20, 10 + i / 20));
+    }
+    auto syncLog = std::make_shared<RecordingObserver>();
+    BattleVisitor syncVisitor;
+    syncVisitor.addObserver(syncLog);
+    reference.startBattle(3.0, syncVisitor);
+    EXPECT_EQ(log->events, syncLog->events);
+}
+
+// Держит поток доставки на первом событии, пока не открыт gate
+class GatedObserver : public RecordingObserver {
+public:
+    std::atomic<bool> gate{false};
+    void onKill(const KillEvent& event) override {
+        while (!gate.load()) {
+            std::this_thread::yield();
+        }
+        RecordingObserver::onKill(event);
+    }
+};
+
+TEST(AsyncPipelineTest, NewLocalNamesDoNotWaitForConsumer) {
+    NPCStore dragons, bulls;
+    for (int i = 0; i < 200; ++i) {
+        dragons.add(NPCType::Dragon, "D" + std::to_string(i), 0, 0);
+        bulls.add(NPCType::Bull, "B" + std::to_string(i), 0, 0);
+    }
+    auto gated = std::make_shared<GatedObserver>();
+    BattleVisitor visitor;
+    visitor.addObserver(gated);
+    visitor.enableAsync(1024, Backpressure::Block);
+
+    // Сторож открывает доставку, если боевой цикл всё же ждёт потребителя
+    std::atomic<bool> done{false};
+    std::atomic<bool> openedByWatchdog{false};
+    std::thread watchdog([&]() {
+        for (int k = 0; k < 500 && !done.load(); ++k) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (!done.load()) {
+            openedByWatchdog = true;
+        }
+        gated->gate = true;
+    });
+    // Каждое событие пары из разных хранилищ добавляет два новых имени
+    for (size_t i = 0; i < 200; ++i) {
+        visitor.notifyFight(dragons, i, bulls, i, BattleOutcome::AttackerKills);
+    }
+    done = true;
+    watchdog.join();
+    EXPECT_FALSE(openedByWatchdog);
+
+    visitor.notifyBattleEnd();
+    ASSERT_EQ(gated->events.size(), 200u);
+    EXPECT_EQ(gated->events.front(), "D0>B0");
+    EXPECT_EQ(gated->events.back(), "D199>B199");
+}
+
+// Тесты многопоточного боевого режима
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+    for (size_t count : {0, 1, 3, 1000}) {
+        std::vector<std::atomic<int>> hits(count);
+        pool.parallelFor(count, [&](size_t k) { hits[k].fetch_add(1); });
+        for (size_t k = 0; k < count; ++k) {
+            EXPECT_EQ(hits[k].load(), 1) << "index " << k;
+        }
+    }
+}
+
+TEST(ParallelBattleTest, ViewsSeeParallelKills) {
+    Editor editor;
+    // Потоки использует одновременный бой
+    editor.setBattleMode(BattleMode::Simultaneous);
+    editor.setThreadCount(4);
+    editor.addNPC(NPCFactory::createNPC("Dragon", "D", 10, 10));
+    editor.addNPC(NPCFactory::createNPC("Bull", "B", 12, 10));
+    auto bull = editor.getNPC(1);
+
+    BattleVisitor visitor;
+    editor.startBattle(5, visitor);
+    EXPECT_FALSE(bull->isAlive());
+
+    editor.setThreadCount(1);
+    EXPECT_EQ(editor.getThreadCount(), 1);
+}
+
+// Тесты таблицы имён и событий по номерам имён
+TEST(NameTableTest, InternsAndReleasesNames) {
+    NameTable names;
+    NameId a = names.intern("Smaug");
+    NameId b = names.intern("Ferdinand");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(names.intern("Smaug"), a);  // Повторное имя — тот же номер
+    EXPECT_EQ(names.text(a), "Smaug");
+    EXPECT_EQ(names.size(), 2);
+
+    names.release(a);
+    EXPECT_TRUE(names.contains("Smaug"));  // Осталась вторая ссылка
+    names.release(a);
+    EXPECT_FALSE(names.contains("Smaug"));
+
+    // Освободившийся номер используется повторно
+    EXPECT_EQ(names.intern("Kermit"), a);
+    NameId found = 0;
+    EXPECT_TRUE(names.find("Ferdinand", found));
+    EXPECT_EQ(found, b);
+}
+
+TEST(NameTableTest, GrowthKeepsIssuedNamesInPlace) {
+    NameTable names;
+    NameId first = names.intern("Smaug");
+    const char* text = names.text(first).data();
+    for (int i = 0; i < 100000; ++i) {
+        names.intern("N" + std::to_string(i));
+    }
+    // Рост таблицы не перемещает записанные строки
+    EXPECT_EQ(names.text(first).data(), text);
+    EXPECT_EQ(names.text(first), "Smaug");
+    NameId last;
+    ASSERT_TRUE(names.find("N99999", last));
+    EXPECT_EQ(names.text(last), "N99999");
+}
+
+class CountingObserver : public BattleObserver {
+public:
+    size_t kills = 0;
+    size_t mutual = 0;
+    void onKill(const KillEvent& event) override {
+        ++kills;
+        mutual += event.mutual ? 1 : 0;
+    }
+};
+
+TEST(NameTableTest, InternNewRejectsKnownNames) {
+    NameTable names;
+    NameId a, b;
+    ASSERT_TRUE(names.internNew("Smaug", a));
+    EXPECT_FALSE(names.internNew("Smaug", b));
+    EXPECT_EQ(names.size(), 1u);
+    EXPECT_EQ(names.text(a), "Smaug");
+
+    // Отвергнутая копия не занимает номер надолго и не ломает найденное имя
+    ASSERT_TRUE(names.internNew("Ferdinand", b));
+    EXPECT_NE(a, b);
+    NameId found;
+    ASSERT_TRUE(names.find("Smaug", found));
+    EXPECT_EQ(found, a);
+    names.release(a);
+    EXPECT_FALSE(names.contains("Smaug"));
+    EXPECT_TRUE(names.contains("Ferdinand"));
+}
+
+TEST(NameTableTest, StoreBattleNotificationsDoNotAllocate) {
+    NPCStore store;
+    for (int i = 0; i < 100; ++i) {
+        store.add(NPCType::Dragon, "Dragon" + std::to_string(i), 0, 0);
+    }
+    auto counter = std::make_shared<CountingObserver>();
+    BattleVisitor visitor;
+    visitor.addObserver(counter);
+
+    size_t before = allocationCount.load();
+    for (size_t i = 0; i + 1 < store.size(); i += 2) {
+        visitor.fight(store, i, i + 1, BattleOutcome::MutualKill);
+    }
+    EXPECT_EQ(allocationCount.load(), before);
+    EXPECT_EQ(counter->kills, 50);
+    EXPECT_EQ(counter->mutual, 50);
+}
+
+TEST(NameTableTest, PrintingSinksResolveNames) {
+    std::remove("test_names.log");
+    auto log = std::make_shared<FileObserver>("test_names.log");
+    BattleVisitor visitor;
+    visitor.addObserver(log);
+
+    NPCStore store;
+    store.add(NPCType::Bull, "B1", 0, 0);
+    store.add(NPCType::Bull, "B2", 0, 0);
+    visitor.fight(store, 0, 1, BattleOutcome::MutualKill);
+
+    Dragon dragon("D", 0, 0);
+    Bull bull("B", 0, 0);
+    visitor.fight(dragon, bull);
+    visitor.notifyBattleEnd();
+
+    EXPECT_EQ(readWholeFile("test_names.log"),
+              "[СОБЫТИЕ] B1 и B2 убил друг друга\n[СОБЫТИЕ] D убил B\n");
+}
+
+// Тесты повторного боя
+TEST(IncrementalBattleTest, RebattleMatchesFullPairScan) {
+    for (double range : {5.0, 30.0}) {
+        std::mt19937 rng(11);
+        Editor editor;
+        std::vector<std::shared_ptr<NPC>> reference;
+        auto editorLog = std::make_shared<RecordingObserver>();
+        BattleVisitor editorVisitor;
+        editorVisitor.addObserver(editorLog);
+        auto fullLog = std::make_shared<RecordingObserver>();
+        BattleVisitor fullVisitor;
+        fullVisitor.addObserver(fullLog);
+
+        size_t next = 0;
+        for (size_t round = 0; round < 4; ++round) {
+            for (size_t k = 0; k < 300; ++k, ++next) {
+                auto npc = makeRandomNPC(rng, next);
+                editor.addNPC(npc);
+                reference.push_back(NPCFactory::createNPC(npc->getType(), npc->getName(),
+                                                          npc->getX(), npc->getY()));
+            }
+            EXPECT_EQ(editor.getDirtyCount(), 300);
+            editor.startBattle(range, editorVisitor);
+            EXPECT_EQ(editor.getDirtyCount(), 0);
+
+            // Эталон: полный перебор всех пар заново
+            for (size_t i = 0; i < reference.size(); ++i) {
+                for (size_t j = i + 1; j < reference.size(); ++j) {
+                    if (reference[i]->isAlive() && reference[j]->isAlive() &&
+                        reference[i]->distanceTo(*reference[j]) <= range) {
+                        reference[i]->accept(fullVisitor, *reference[j]);
+                    }
+                }
+            }
+            ASSERT_EQ(editorLog->events, fullLog->events) << "range " << range << ", round " << round;
+        }
+    }
+}
+
+TEST(IncrementalBattleTest, RemovingDeadKeepsCheckedPrefix) {
+    Editor editor;
+    editor.addNPC(NPCFactory::createNPC("Dragon", "D", 10, 10));
+    editor.addNPC(NPCFactory::createNPC("Bull", "B", 12, 10));
+    editor.addNPC(NPCFactory::createNPC("Frog", "F", 100, 100));
+    BattleVisitor visitor;
+    editor.startBattle(5, visitor);
+
+    editor.addNPC(NPCFactory::createNPC("Bull", "B2", 14, 10));
+    editor.removeDeadNPCs();
+    EXPECT_EQ(editor.getNPCCount(), 3);
+    EXPECT_EQ(editor.getDirtyCount(), 1);
+
+    // Новый бык рядом с драконом погибает при повторном бое
+    auto log = std::make_shared<RecordingObserver>();
+    visitor.addObserver(log);
+    editor.startBattle(5, visitor);
+    EXPECT_EQ(log->events, std::vector<std::string>{"D>B2"});
+
+    // Больший радиус требует полного прохода
+    editor.addNPC(NPCFactory::createNPC("Bull", "B3", 100, 104));
+    editor.startBattle(10, visitor);
+    EXPECT_EQ(editor.getDirtyCount(), 0);
+}
+
+// Тесты статистики боя
+TEST(BattleStatsTest, CountsMatchEventLog) {
+    for (size_t threadCount : {1, 4}) {
+        std::mt19937 rng(5);
+        Editor editor;
+        editor.setThreadCount(threadCount);
+        for (size_t i = 0; i < 2000; ++i) {
+            editor.addNPC(makeRandomNPC(rng, i));
+        }
+        auto log = std::make_shared<RecordingObserver>();
+        BattleVisitor visitor;
+        visitor.addObserver(log);
+        BattleStats stats;
+        editor.startBattle(20, visitor, &stats);
+
+        size_t mutual = 0;
+        for (const auto& event : log->events) {
+            mutual += event.find(">друг друга") != std::string::npos ? 1 : 0;
+        }
+        size_t dead = 0;
+        for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+            dead += editor.getStore().isAlive(i) ? 0 : 1;
+        }
+        EXPECT_EQ(stats.fights, log->events.size()) << "threads " << threadCount;
+        EXPECT_EQ(stats.totalKills(), log->events.size() + mutual);
+        EXPECT_EQ(stats.totalKills(), dead);
+        EXPECT_GE(stats.candidatePairs, stats.fights);
+        EXPECT_GE(stats.rangeChecks, stats.candidatePairs);
+        // Жабы никого не убивают
+        for (size_t victim = 0; victim < NPC_TYPE_COUNT; ++victim) {
+            EXPECT_EQ(stats.kills[static_cast<size_t>(NPCType::Frog)][victim], 0);
+        }
+        EXPECT_GT(stats.kills[static_cast<size_t>(NPCType::Dragon)][static_cast<size_t>(NPCType::Bull)], 0);
+    }
+}
+
+TEST(BattleStatsTest, ResetForEachBattle) {
+    Editor editor;
+    editor.addNPC(NPCFactory::createNPC("Dragon", "D", 10, 10));
+    editor.addNPC(NPCFactory::createNPC("Bull", "B", 12, 10));
+    BattleVisitor visitor;
+    BattleStats stats;
+    editor.startBattle(5, visitor, &stats);
+    EXPECT_EQ(stats.fights, 1);
+    EXPECT_EQ(stats.kills[static_cast<size_t>(NPCType::Dragon)][static_cast<size_t>(NPCType::Bull)], 1);
+
+    editor.startBattle(5, visitor, &stats);
+    EXPECT_EQ(stats.fights, 0);
+    EXPECT_EQ(stats.totalKills(), 0);
+
+    std::ostringstream report;
+    stats.print(report);
+    EXPECT_NE(report.str().find("Боёв: 0"), std::string::npos);
+}
+
+// Тесты пакетного режима
+TEST(BatchTest, ParsesCommandLine) {
+    const char* argv[] = {"editor", "--load", "a.txt", "--battle", "50", "--save", "out.bin",
+                          "--quiet", "--jobs", "3"};
+    BatchOptions options;
+    std::string error;
+    ASSERT_TRUE(BatchRunner::parseArguments(10, argv, options, error)) << error;
+    ASSERT_EQ(options.scenarios.size(), 1);
+    EXPECT_EQ(options.scenarios[0].load, "a.txt");
+    EXPECT_TRUE(options.scenarios[0].battle);
+    EXPECT_EQ(options.scenarios[0].range, 50.0);
+    EXPECT_EQ(options.scenarios[0].save, "out.bin");
+    EXPECT_TRUE(options.quiet);
+    EXPECT_EQ(options.jobs, 3);
+
+    const char* bad[] = {"editor", "--battle", "-5"};
+    BatchOptions rejected;
+    EXPECT_FALSE(BatchRunner::parseArguments(3, bad, rejected, error));
+    const char* unknown[] = {"editor", "--fast"};
+    EXPECT_FALSE(BatchRunner::parseArguments(2, unknown, rejected, error));
+    const char* empty[] = {"editor", "--quiet"};
+    EXPECT_FALSE(BatchRunner::parseArguments(2, empty, rejected, error));
+}
+
+TEST(BatchTest, RunsManifestInParallel) {
+    const size_t count = 6;
+    {
+        std::ofstream manifest("test_manifest.txt");
+        manifest << "# сценарии\n\n";
+        for (size_t k = 0; k < count; ++k) {
+            std::string input = "test_batch_in" + std::to_string(k) + ".txt";
+            std::ofstream world(input);
+            world << "Dragon D" << k << " 10 10\nBull B" << k << " 12 10\nFrog F" << k << " 300 300\n";
+            manifest << input << (k % 2 ? " -" : " 5") << " test_batch_out" << k << ".txt\n";
+        }
+        manifest << "missing_world.txt 5\n";
+    }
+
+    const char* argv[] = {"editor", "--manifest", "test_manifest.txt", "--jobs", "4", "--quiet"};
+    BatchOptions options;
+    std::string error;
+    ASSERT_TRUE(BatchRunner::parseArguments(6, argv, options, error)) << error;
+    ASSERT_EQ(options.scenarios.size(), count + 1);
+
+    std::ostringstream out, err;
+    EXPECT_EQ(BatchRunner::run(options, out, err), 1);  // Нет файла мира
+    EXPECT_EQ(out.str(), "");
+    EXPECT_NE(err.str().find("missing_world.txt"), std::string::npos);
+
+    for (size_t k = 0; k < count; ++k) {
+        Editor result;
+        ASSERT_TRUE(result.loadFromFile("test_batch_out" + std::to_string(k) + ".txt"));
+        // Бык погибает только в сценариях с боем
+        EXPECT_EQ(result.getNPCCount(), k % 2 ? 3 : 2) << "scenario " << k;
+    }
+}
+
+TEST(BatchTest, ParallelOutputFollowsManifestOrder) {
+    const size_t count = 8;
+    {
+        std::ofstream manifest("test_manifest_order.txt");
+        for (size_t k = 0; k < count; ++k) {
+            std::string input = "test_order_in" + std::to_string(k) + ".txt";
+            std::ofstream world(input);
+            for (size_t n = 0; n < 50; ++n) {
+                world << "Dragon D" << k << "_" << n << " " << n << " 10\n"
+                      << "Bull B" << k << "_" << n << " " << n << " 11\n";
+            }
+            manifest << input << " 5\n";
+        }
+    }
+
+    std::string expected;
+    for (size_t jobs : {1, 4}) {
+        BatchOptions options;
+        std::string error;
+        ASSERT_TRUE(BatchRunner::loadManifest("test_manifest_order.txt", options.scenarios, error)) << error;
+        options.jobs = jobs;
+        std::ostringstream out, err;
+        EXPECT_EQ(BatchRunner::run(options, out, err), 0u);
+        if (jobs == 1) {
+            expected = out.str();
+            // События сценария идут перед его итогом
+            size_t first = expected.find("[СОБЫТИЕ] D0_0 ");
+            size_t summary = expected.find("test_order_in0.txt: NPC");
+            ASSERT_NE(first, std::string::npos);
+            EXPECT_LT(first, summary);
+            EXPECT_LT(summary, expected.find("[СОБЫТИЕ] D1_0 "));
+        } else {
+            EXPECT_EQ(out.str(), expected);
+        }
+    }
+}
+
+// Тесты симуляции
+TEST(DynamicGridTest, NeighboursMatchBruteForceAfterMoves) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(-20, 520);
+    const double range = 12.0;
+    DynamicGrid grid(MapBounds{0, 0, 500, 500}, range);
+    std::vector<double> xs(500), ys(500);
+    grid.reset(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+        grid.insert(i, xs[i], ys[i]);
+    }
+    for (int round = 0; round < 5; ++round) {
+        for (size_t i = 0; i < xs.size(); ++i) {
+            xs[i] = coord(rng);
+            ys[i] = coord(rng);
+            grid.move(i, xs[i], ys[i]);
+        }
+        grid.remove((size_t)round);
+        for (size_t i = 0; i < xs.size(); i += 7) {
+            std::vector<size_t> found;
+            grid.forEachNeighbour(xs[i], ys[i], [&](size_t j) {
+                if (std::hypot(xs[j] - xs[i], ys[j] - ys[i]) <= range) {
+                    found.push_back(j);
+                }
+            });
+            std::sort(found.begin(), found.end());
+            std::vector<size_t> expected;
+            for (size_t j = 0; j < xs.size(); ++j) {
+                if (grid.contains(j) && std::hypot(xs[j] - xs[i], ys[j] - ys[i]) <= range) {
+                    expected.push_back(j);
+                }
+            }
+            ASSERT_EQ(found, expected) << "round " << round << ", npc " << i;
+        }
+    }
+}
+
+TEST(DynamicGridTest, ParkedNPCsAreSkippedOnlyByRangeSearch) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(0, 100);
+    const double range = 8.0;
+    DynamicGrid grid(MapBounds{0, 0, 100, 100}, range);
+    std::vector<double> xs(300), ys(300);
+    grid.reset(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+        grid.insert(i, xs[i], ys[i]);
+        if (i % 3 == 0) {
+            grid.park(i);
+        }
+    }
+    // Отложенные остаются отложенными и после смены клетки
+    for (size_t i = 0; i < xs.size(); i += 2) {
+        xs[i] = coord(rng);
+        ys[i] = coord(rng);
+        grid.move(i, xs[i], ys[i]);
+    }
+    RangeScratch scratch;
+    for (size_t i = 0; i < xs.size(); i += 5) {
+        std::vector<size_t> within, all;
+        grid.forEachWithin(xs.data(), ys.data(), xs[i], ys[i], range, scratch,
+                           [&](size_t j) { within.push_back(j); });
+        grid.forEachInRect(0, 0, 100, 100, [&](size_t j) { all.push_back(j); });
+        std::sort(within.begin(), within.end());
+        std::vector<size_t> expected;
+        for (size_t j = 0; j < xs.size(); ++j) {
+            if (j % 3 != 0 && std::hypot(xs[j] - xs[i], ys[j] - ys[i]) <= range) {
+                expected.push_back(j);
+            }
+        }
+        ASSERT_EQ(within, expected) << i;
+        ASSERT_EQ(all.size(), xs.size());
+    }
+}
+
+TEST(SimulationTest, StationaryTickMatchesStaticBattle) {
+    std::mt19937 rng(9);
+    Editor simulated;
+    Editor reference;
+    for (size_t i = 0; i < 2000; ++i) {
+        auto npc = makeRandomNPC(rng, i);
+        simulated.addNPC(npc);
+        reference.addNPC(NPCFactory::createNPC(npc->getType(), npc->getName(),
+                                               npc->getX(), npc->getY()));
+    }
+    SimulationConfig config;
+    config.speed = 0;
+    config.range = 15;
+    Simulation simulation(simulated, config);
+    auto simulatedLog = std::make_shared<RecordingObserver>();
+    BattleVisitor simulatedVisitor;
+    simulatedVisitor.addObserver(simulatedLog);
+    simulation.run(1, simulatedVisitor);
+
+    auto referenceLog = std::make_shared<RecordingObserver>();
+    BattleVisitor referenceVisitor;
+    referenceVisitor.addObserver(referenceLog);
+    reference.startBattle(15, referenceVisitor);
+
+    EXPECT_EQ(simulatedLog->events, referenceLog->events);
+    ASSERT_EQ(simulation.getTimings().size(), 1);
+    size_t alive = 0;
+    for (size_t i = 0; i < simulated.getNPCCount(); ++i) {
+        alive += simulated.getStore().isAlive(i) ? 1 : 0;
+    }
+    EXPECT_EQ(simulation.getTimings()[0].alive, alive);
+    EXPECT_EQ(simulation.getTimings()[0].kills, 2000 - alive);
+}
+
+TEST(SimulationTest, NegativeOrNaNRangeFightsNobody) {
+    for (double range : {-1.0, std::nan("")}) {
+        Editor editor;
+        editor.addNPC(std::make_shared<Dragon>("Smaug", 10, 10));
+        editor.addNPC(std::make_shared<Bull>("Ferdinand", 10, 10));
+        SimulationConfig config;
+        config.speed = 0;
+        config.range = range;
+        Simulation simulation(editor, config);
+        BattleVisitor visitor;
+        simulation.run(3, visitor);
+        EXPECT_TRUE(editor.getStore().isAlive(0));
+        EXPECT_TRUE(editor.getStore().isAlive(1));
+        EXPECT_EQ(simulation.getTimings().back().kills, 0u);
+    }
+}
+
+TEST(SimulationTest, MovementIsReproducibleAndStaysOnMap) {
+    for (MovementMode mode : {MovementMode::RandomWalk, MovementMode::Waypoint}) {
+        std::vector<std::string> logs[2];
+        std::vector<double> positions[2];
+        for (int run = 0; run < 2; ++run) {
+            std::mt19937 rng(21);
+            Editor editor;
+            for (size_t i = 0; i < 500; ++i) {
+                editor.addNPC(makeRandomNPC(rng, i));
+            }
+            auto tracked = editor.getNPC(0);
+            SimulationConfig config;
+            config.movement = mode;
+            config.speed = 50;
+            config.range = 3;
+            config.seed = 77;
+            Simulation simulation(editor, config);
+            auto log = std::make_shared<RecordingObserver>();
+            BattleVisitor visitor;
+            visitor.addObserver(log);
+            simulation.run(20, visitor);
+            EXPECT_EQ(simulation.getTimings().size(), 20);
+
+            const NPCStore& store = editor.getStore();
+            for (size_t i = 0; i < store.size(); ++i) {
+                ASSERT_GE(store.x(i), 0);
+                ASSERT_LE(store.x(i), Editor::MAP_SIZE);
+                ASSERT_GE(store.y(i), 0);
+                ASSERT_LE(store.y(i), Editor::MAP_SIZE);
+                positions[run].push_back(store.x(i));
+                positions[run].push_back(store.y(i));
+            }
+            // Объект NPC видит новые координаты
+            EXPECT_EQ(tracked->getX(), store.x(0));
+            logs[run] = log->events;
+        }
+        EXPECT_EQ(logs[0], logs[1]);
+        EXPECT_EQ(positions[0], positions[1]);
+    }
+}
+
+TEST(SimulationTest, WaypointTargetsFollowNPCAfterRemoval) {
+    Editor editor;
+    NPCHandle handles[3];
+    editor.addNPC(std::make_shared<Dragon>("Smaug", 100, 100), &handles[0]);
+    editor.addNPC(std::make_shared<Dragon>("Fafnir", 200, 200), &handles[1]);
+    editor.addNPC(std::make_shared<Dragon>("Glaurung", 300, 300), &handles[2]);
+    SimulationConfig config;
+    config.movement = MovementMode::Waypoint;
+    config.range = -1;
+    Simulation simulation(editor, config);
+    BattleVisitor visitor;
+
+    // Направление движения NPC за один такт
+    auto headings = [&]() {
+        double before[3][2];
+        for (int k = 0; k < 3; ++k) {
+            auto npc = editor.getNPC(handles[k]);
+            if (npc) {
+                before[k][0] = npc->getX();
+                before[k][1] = npc->getY();
+            }
+        }
+        simulation.run(1, visitor);
+        std::vector<double> result;
+        for (int k = 0; k < 3; ++k) {
+            auto npc = editor.getNPC(handles[k]);
+            if (npc) {
+                result.push_back(npc->getX() - before[k][0]);
+                result.push_back(npc->getY() - before[k][1]);
+            }
+        }
+        return result;
+    };
+    std::vector<double> first = headings();
+
+    // Glaurung переносится на место Smaug и должен идти к своей цели
+    editor.getNPC(handles[0])->kill();
+    editor.removeDeadNPCs();
+    ASSERT_EQ(editor.getStore().indexOf(handles[2]), 0u);
+    std::vector<double> second = headings();
+    ASSERT_EQ(second.size(), 4u);
+    for (size_t k = 0; k < 4; ++k) {
+        EXPECT_NEAR(second[k], first[k + 2], 1e-9) << k;
+    }
+}
+
+// Тесты для устойчивых ссылок на NPC
+TEST(NPCHandleTest, HandlesSurviveRemovalAndDetectStaleOnes) {
+    NPCStore store;
+    std::vector<NPCHandle> handles;
+    for (int i = 0; i < 6; ++i) {
+        handles.push_back(store.handle(store.add(NPCType::Frog, "F" + std::to_string(i), i, 0)));
+    }
+    store.kill(1);
+    store.kill(4);
+    store.removeDead();
+
+    ASSERT_EQ(store.size(), 4);
+    for (int i : {0, 2, 3, 5}) {
+        size_t index = store.indexOf(handles[i]);
+        ASSERT_NE(index, NPCStore::npos);
+        EXPECT_EQ(store.name(index), "F" + std::to_string(i));
+        EXPECT_EQ(store.handle(index), handles[i]);
+    }
+    EXPECT_FALSE(store.isValid(handles[1]));
+    EXPECT_EQ(store.indexOf(handles[4]), NPCStore::npos);
+
+    // Ячейка переиспользуется, но старая ссылка на неё не оживает
+    NPCHandle reused = store.handle(store.add(NPCType::Bull, "B", 0, 0));
+    EXPECT_TRUE(reused.slot == handles[1].slot || reused.slot == handles[4].slot);
+    EXPECT_FALSE(store.isValid(handles[1]));
+    EXPECT_FALSE(store.isValid(handles[4]));
+
+    store.clear();
+    EXPECT_FALSE(store.isValid(reused));
+    NPCHandle fresh = store.handle(store.add(NPCType::Bull, "B", 0, 0));
+    EXPECT_TRUE(store.isValid(fresh));
+    EXPECT_FALSE(store.isValid(handles[0]));
+}
+
+TEST(NPCHandleTest, RemovalKeepsCheckedPrefix) {
+    NPCStore store;
+    for (int i = 0; i < 8; ++i) {
+        store.add(NPCType::Frog, "F" + std::to_string(i), i, 0);
+    }
+    // Первые пять — проверенные; погибают двое из них и один новый
+    store.kill(0);
+    store.kill(3);
+    store.kill(6);
+    size_t prefix = store.removeDead(5);
+
+    ASSERT_EQ(prefix, 3);
+    ASSERT_EQ(store.size(), 5);
+    std::set<std::string> checked, fresh;
+    for (size_t i = 0; i < store.size(); ++i) {
+        (i < prefix ? checked : fresh).insert(std::string(store.name(i)));
+    }
+    EXPECT_EQ(checked, (std::set<std::string>{"F1", "F2", "F4"}));
+    EXPECT_EQ(fresh, (std::set<std::string>{"F5", "F7"}));
+}
+
+TEST(EditorTest, GetNPCByHandle) {
+    Editor editor;
+    NPCHandle dragon, bull;
+    ASSERT_TRUE(editor.addNPC(std::make_shared<Dragon>("D", 10, 10), &dragon));
+    ASSERT_TRUE(editor.addNPC(std::make_shared<Bull>("B", 20, 20), &bull));
+    NPCHandle rejected;
+    EXPECT_FALSE(editor.addNPC(std::make_shared<Frog>("D", 1, 1), &rejected));
+    EXPECT_FALSE(editor.isValid(rejected));
+
+    editor.getNPC(dragon)->kill();
+    editor.removeDeadNPCs();
+    EXPECT_EQ(editor.getNPC(dragon), nullptr);
+    ASSERT_NE(editor.getNPC(bull), nullptr);
+    EXPECT_EQ(editor.getNPC(bull)->getName(), "B");
+    EXPECT_EQ(editor.getHandle(0), bull);
+}
+
+// Тесты для журнала изменений
+static void removeJournal(const std::string& path) {
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".log").c_str());
+}
+
+// Мир как множество строк "тип имя x y жив" (порядок после восстановления не важен)
+static std::vector<std::string> worldLines(const Editor& editor) {
+    const NPCStore& store = editor.getStore();
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < store.size(); ++i) {
+        lines.push_back(NPC::format(store.type(i), store.name(i), store.x(i), store.y(i)) +
+                        (store.isAlive(i) ? " +" : " -"));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+TEST(JournalTest, RecoversAddsKillsBattlesAndRemovals) {
+    removeJournal("test_journal");
+    std::mt19937 rng(5);
+    std::vector<std::string> expected;
+    {
+        Editor editor;
+        ASSERT_TRUE(editor.openJournal("test_journal"));
+        for (size_t i = 0; i < 300; ++i) {
+            editor.addNPC(makeRandomNPC(rng, i));
+        }
+        editor.getNPC(3)->kill();
+        BattleVisitor visitor;
+        editor.startBattle(5, visitor);
+        editor.removeDeadNPCs();
+        // Освободившееся имя занимает новый NPC; бой в несколько потоков
+        editor.addNPC(std::make_shared<Dragon>(std::string(editor.getStore().name(0)) + "x", 1, 1));
+        editor.setThreadCount(4);
+        editor.startBattle(40, visitor);
+        expected = worldLines(editor);
+    }
+
+    Editor recovered;
+    ASSERT_TRUE(recovered.openJournal("test_journal"));
+    EXPECT_EQ(worldLines(recovered), expected);
+
+    // Очистка тоже переживает перезапуск
+    recovered.clear();
+    recovered.addNPC(std::make_shared<Frog>("Last", 2, 2));
+    recovered.closeJournal();
+    Editor again;
+    ASSERT_TRUE(again.openJournal("test_journal"));
+    EXPECT_EQ(worldLines(again), std::vector<std::string>{worldLines(recovered)});
+    removeJournal("test_journal");
+}
+
+TEST(JournalTest, CompactionKeepsLogSmall) {
+    removeJournal("test_compact");
+    JournalOptions options;
+    options.groupCommit = 16;
+    options.durable = false;
+    options.compactBytes = 512;
+    std::vector<std::string> expected;
+    {
+        Editor editor;
+        ASSERT_TRUE(editor.openJournal("test_compact", options));
+        for (int i = 0; i < 200; ++i) {
+            editor.addNPC(std::make_shared<Frog>("F" + std::to_string(i), i, i));
+        }
+        expected = worldLines(editor);
+    }
+    // Журнал не длиннее снимка плюс одна группа
+    EXPECT_LT(std::filesystem::file_size("test_compact.log"),
+              std::filesystem::file_size("test_compact.snapshot") + 16 * 64);
+
+    Editor recovered;
+    ASSERT_TRUE(recovered.openJournal("test_compact", options));
+    EXPECT_EQ(worldLines(recovered), expected);
+    removeJournal("test_compact");
+}
+
+TEST(JournalTest, TornTailIsDropped) {
+    removeJournal("test_torn");
+    JournalOptions options;
+    options.groupCommit = 1;
+    options.durable = false;
+    {
+        NPCStore store;
+        Journal journal("test_torn", options);
+        ASSERT_TRUE(journal.open(store));
+        journal.add(NPCType::Dragon, "A", 1, 1);
+        journal.add(NPCType::Bull, "B", 2, 2);
+        journal.add(NPCType::Frog, "C", 3, 3);
+    }
+    // Сбой посреди записи последней группы
+    std::filesystem::resize_file("test_torn.log", std::filesystem::file_size("test_torn.log") - 5);
+    {
+        NPCStore store;
+        Journal journal("test_torn", options);
+        ASSERT_TRUE(journal.open(store));
+        EXPECT_EQ(journal.getReplayedCount(), 2);
+        EXPECT_EQ(store.size(), 2);
+        journal.add(NPCType::Frog, "D", 4, 4);
+    }
+    NPCStore store;
+    Journal journal("test_torn", options);
+    ASSERT_TRUE(journal.open(store));
+    EXPECT_EQ(journal.getReplayedCount(), 3);
+    EXPECT_TRUE(store.containsName("D"));
+    EXPECT_FALSE(store.containsName("C"));
+    removeJournal("test_torn");
+}
+
+TEST(JournalTest, LogOfPreviousSnapshotIsIgnored) {
+    removeJournal("test_stale");
+    JournalOptions options;
+    options.durable = false;
+    std::string oldLog;
+    {
+        NPCStore store;
+        store.add(NPCType::Dragon, "A", 0, 0);
+        Journal journal("test_stale", options);
+        ASSERT_TRUE(journal.open(store));
+        journal.add(NPCType::Frog, "F", 1, 1);
+        ASSERT_TRUE(journal.commit());
+        oldLog = readWholeFile("test_stale.log");
+        store.add(NPCType::Frog, "F", 1, 1);
+        ASSERT_TRUE(journal.compact(store));
+    }
+    // Сбой между заменой снимка и заменой журнала
+    std::ofstream("test_stale.log", std::ios::binary) << oldLog;
+
+    NPCStore store;
+    Journal journal("test_stale", options);
+    ASSERT_TRUE(journal.open(store));
+    EXPECT_EQ(journal.getReplayedCount(), 0);
+    EXPECT_EQ(store.size(), 2);
+    removeJournal("test_stale");
+}
+
+TEST(JournalTest, CorruptSnapshotLeavesWorldIntact) {
+    removeJournal("test_corrupt");
+    JournalOptions options;
+    options.durable = false;
+    {
+        NPCStore store;
+        store.add(NPCType::Dragon, "A", 0, 0);
+        Journal journal("test_corrupt", options);
+        ASSERT_TRUE(journal.open(store));
+    }
+    std::string snapshot = readWholeFile("test_corrupt.snapshot");
+    snapshot[snapshot.size() / 2] ^= 0x5a;
+    std::ofstream("test_corrupt.snapshot", std::ios::binary) << snapshot;
+
+    Editor editor;
+    editor.addNPC(std::make_shared<Bull>("Kept", 1, 1));
+    editor.addNPC(std::make_shared<Frog>("Also", 2, 2));
+    const std::vector<std::string> before = worldLines(editor);
+    std::string error;
+    EXPECT_FALSE(editor.openJournal("test_corrupt", options, &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_EQ(worldLines(editor), before);
+    removeJournal("test_corrupt");
+}
+
+// Тесты для реестра типов
+TEST(NPCTypesTest, ParseRoundTripsAndRejectsUnknownNames) {
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        NPCType type = static_cast<NPCType>(t);
+        NPCType parsed;
+        ASSERT_TRUE(NPCTypes::parse(npcTypeName(type), parsed));
+        EXPECT_EQ(parsed, type);
+        EXPECT_EQ(NPCTypes::create(type, "N", 1, 2)->getType(), npcTypeName(type));
+    }
+    NPCType parsed;
+    for (std::string_view bad : {"", "dragon", "Bul", "Bulls", "Frog "}) {
+        EXPECT_FALSE(NPCTypes::parse(bad, parsed)) << bad;
+    }
+    EXPECT_FALSE(NPCTypes::parse(std::string_view("Frog\0", 5), parsed));
+}
+
+TEST(NPCTypesTest, DispatchFollowsOutcomeTable) {
+    for (size_t a = 0; a < NPC_TYPE_COUNT; ++a) {
+        for (size_t d = 0; d < NPC_TYPE_COUNT; ++d) {
+            auto attacker = NPCTypes::create(static_cast<NPCType>(a), "A", 0, 0);
+            auto defender = NPCTypes::create(static_cast<NPCType>(d), "D", 0, 0);
+            BattleVisitor visitor;
+            attacker->accept(visitor, *defender);
+            BattleOutcome outcome = battleOutcome(static_cast<NPCType>(a), static_cast<NPCType>(d));
+            EXPECT_EQ(defender->isAlive(), outcome == BattleOutcome::None) << a << " " << d;
+            EXPECT_EQ(attacker->isAlive(), outcome != BattleOutcome::MutualKill) << a << " " << d;
+        }
+    }
+}
+
+TEST(NPCTypesTest, PoolKeepsOneSlabPoolPerType) {
+    NPCPool pool;
+    pool.create(NPCType::Frog, "F", 1, 1);
+    pool.create(NPCType::Dragon, "D", 1, 1);
+    auto bull = pool.create(NPCType::Bull, "B", 1, 1);
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_EQ(bull->getTypeTag(), NPCType::Bull);
+    EXPECT_EQ(bull->getType(), "Bull");
+}
+
+// Тесты для политик событий боя
+TEST(BattleSinkTest, SilentBattleKillsTheSameNPCs) {
+    for (size_t threads : {1, 4}) {
+        Editor loud, silent;
+        std::mt19937 rng(11);
+        for (size_t i = 0; i < 2000; ++i) {
+            auto npc = makeRandomNPC(rng, i);
+            loud.addNPC(npc);
+            silent.addNPC(NPCFactory::createNPC(npc->getType(), npc->getName(), npc->getX(), npc->getY()));
+        }
+        loud.setThreadCount(threads);
+        silent.setThreadCount(threads);
+
+        BattleVisitor withLog;
+        auto log = std::make_shared<RecordingObserver>();
+        withLog.addObserver(log);
+        BattleVisitor withoutObservers;
+        BattleStats loudStats, silentStats;
+        for (double range : {8.0, 8.0, 20.0}) {
+            // Второй бой с тем же радиусом идёт по новым NPC
+            loud.addNPC(std::make_shared<Dragon>("Late" + std::to_string(range), 250, 250));
+            silent.addNPC(std::make_shared<Dragon>("Late" + std::to_string(range), 250, 250));
+            loud.startBattle(range, withLog, &loudStats);
+            silent.startBattle(range, withoutObservers, &silentStats);
+            EXPECT_EQ(silentStats.fights, loudStats.fights);
+            EXPECT_EQ(silentStats.totalKills(), loudStats.totalKills());
+        }
+        EXPECT_FALSE(log->events.empty());
+        ASSERT_EQ(loud.getNPCCount(), silent.getNPCCount());
+        for (size_t i = 0; i < loud.getNPCCount(); ++i) {
+            EXPECT_EQ(loud.getStore().isAlive(i), silent.getStore().isAlive(i)) << threads << " " << i;
+        }
+    }
+}
+
+TEST(BattleSinkTest, NullSinkEngineMatchesVisitorEngine) {
+    NPCStore a, b;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coord(0, 100);
+    std::uniform_int_distribution<int> type(0, 2);
+    for (size_t i = 0; i < 500; ++i) {
+        NPCType t = static_cast<NPCType>(type(rng));
+        double x = coord(rng), y = coord(rng);
+        a.add(t, "N" + std::to_string(i), x, y);
+        b.add(t, "N" + std::to_string(i), x, y);
+    }
+    const MapBounds bounds{0, 0, 100, 100};
+    BattleVisitor visitor;
+    BattleEngine::resolve(a, bounds, 4, visitor);
+    BattleEngine::resolve(b, bounds, 4, NullSink());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a.isAlive(i), b.isAlive(i));
+    }
+}
+
+// Тесты для мира из плиток
+static TiledWorldConfig tiledConfig(const std::string& directory, size_t budget) {
+    TiledWorldConfig config;
+    config.directory = directory;
+    config.tileSize = 100;
+    config.tilesX = 3;
+    config.tilesY = 3;
+    config.memoryBudget = budget;
+    return config;
+}
+
+TEST(TiledWorldTest, BattleAcrossBordersMatchesSingleStore) {
+    // Тот же мир в одном редакторе, NPC упорядочены по плиткам
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(0, 300);
+    std::uniform_int_distribution<int> type(0, 2);
+    std::vector<std::pair<uint64_t, std::shared_ptr<NPC>>> npcs;
+    for (size_t i = 0; i < 900; ++i) {
+        auto npc = NPCFactory::createNPC(static_cast<NPCType>(type(rng)), "N" + std::to_string(i),
+                                         coord(rng), coord(rng));
+        uint64_t key = (uint64_t)std::min(2.0, npc->getY() / 100) * 3 + (uint64_t)std::min(2.0, npc->getX() / 100);
+        npcs.emplace_back(key, npc);
+    }
+    std::stable_sort(npcs.begin(), npcs.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    Editor editor;
+    std::filesystem::remove_all("test_tiles");
+    // Бюджет меньше всего мира: плитки выгружаются посреди боя
+    TiledWorld world(tiledConfig("test_tiles", 300 * TiledWorld::BYTES_PER_NPC));
+    for (const auto& entry : npcs) {
+        const NPC& npc = *entry.second;
+        ASSERT_TRUE(editor.addNPC(NPCFactory::createNPC(npc.getTypeTag(), npc.getName(), npc.getX(), npc.getY())));
+        ASSERT_TRUE(world.addNPC(npc.getTypeTag(), npc.getName(), npc.getX(), npc.getY()));
+    }
+    EXPECT_LE(world.getResidentBytes(), 300 * TiledWorld::BYTES_PER_NPC);
+
+    BattleVisitor single, tiled;
+    auto singleLog = std::make_shared<RecordingObserver>();
+    auto tiledLog = std::make_shared<RecordingObserver>();
+    single.addObserver(singleLog);
+    tiled.addObserver(tiledLog);
+    editor.startBattle(12, single);
+    ASSERT_TRUE(world.startBattle(12, tiled));
+    EXPECT_GT(world.getEvictionCount(), 0u);
+    EXPECT_FALSE(singleLog->events.empty());
+    EXPECT_EQ(tiledLog->events, singleLog->events);
+
+    std::set<std::string> expected, actual;
+    for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+        if (editor.getStore().isAlive(i)) {
+            expected.insert(std::string(editor.getStore().name(i)));
+        }
+    }
+    world.forEachNPC(world.getBounds(), [&](const NPCStore& store, size_t i) {
+        actual.insert(std::string(store.name(i)));
+    });
+    EXPECT_EQ(actual, expected);
+    std::filesystem::remove_all("test_tiles");
+
+    // Асинхронная доставка: плитки с недоставленными событиями не выгружаются раньше времени
+    std::filesystem::remove_all("test_tiles_async");
+    TiledWorld asyncWorld(tiledConfig("test_tiles_async", 300 * TiledWorld::BYTES_PER_NPC));
+    for (const auto& entry : npcs) {
+        const NPC& npc = *entry.second;
+        ASSERT_TRUE(asyncWorld.addNPC(npc.getTypeTag(), npc.getName(), npc.getX(), npc.getY()));
+    }
+    BattleVisitor async;
+    auto asyncLog = std::make_shared<RecordingObserver>();
+    async.addObserver(asyncLog);
+    async.enableAsync(64, Backpressure::Block);
+    ASSERT_TRUE(asyncWorld.startBattle(12, async));
+    EXPECT_EQ(asyncLog->events, singleLog->events);
+    std::filesystem::remove_all("test_tiles_async");
+}
+
+TEST(TiledWorldTest, AsyncDeliveryOfBorderFights) {
+    // Пары стоят по обе стороны вертикальных границ: все бои — между плитками
+    std::filesystem::remove_all("test_tiles_border");
+    TiledWorld world(tiledConfig("test_tiles_border", 1 << 20));
+    std::vector<std::string> expected;
+    for (size_t k = 0; k < 150; ++k) {
+        const double border = k % 2 ? 200 : 100;
+        const double y = 1 + (double)k * 1.9;
+        const std::string dragon = "D" + std::to_string(k);
+        const std::string bull = "B" + std::to_string(k);
+        ASSERT_TRUE(world.addNPC(NPCType::Dragon, dragon, border - 0.5, y));
+        ASSERT_TRUE(world.addNPC(NPCType::Bull, bull, border + 0.5, y));
+    }
+
+    BattleVisitor visitor;
+    auto log = std::make_shared<RecordingObserver>();
+    visitor.addObserver(log);
+    visitor.enableAsync(16, Backpressure::Block);
+    ASSERT_TRUE(world.startBattle(1.5, visitor));
+    EXPECT_EQ(visitor.droppedEvents(), 0u);
+    ASSERT_EQ(log->events.size(), 150u);
+    std::set<std::string> events(log->events.begin(), log->events.end());
+    for (size_t k = 0; k < 150; ++k) {
+        EXPECT_EQ(events.count("D" + std::to_string(k) + ">B" + std::to_string(k)), 1u) << k;
+    }
+    std::filesystem::remove_all("test_tiles_border");
+}
+
+TEST(TiledWorldTest, TilesAreEvictedAndReloaded) {
+    const size_t budget = 10 * TiledWorld::BYTES_PER_NPC;
+    std::filesystem::remove_all("test_tiles_lru");
+    {
+        TiledWorld world(tiledConfig("test_tiles_lru", budget));
+        const double corners[4][2] = {{5, 5}, {105, 5}, {5, 105}, {105, 105}};
+        for (size_t i = 0; i < 40; ++i) {
+            // По 10 NPC в четырёх плитках, плитки чередуются
+            const double* at = corners[i % 4];
+            ASSERT_TRUE(world.addNPC(NPCType::Frog, "F" + std::to_string(i), at[0] + i, at[1]));
+            EXPECT_LE(world.getResidentBytes(), budget);
+        }
+        EXPECT_FALSE(world.addNPC(NPCType::Frog, "F0", 5, 5));
+        EXPECT_FALSE(world.addNPC(NPCType::Frog, "Out", 301, 5));
+        EXPECT_GT(world.getEvictionCount(), 0u);
+        EXPECT_GT(world.getLoadCount(), 0u);
+    }
+
+    TiledWorld reopened(tiledConfig("test_tiles_lru", budget));
+    EXPECT_EQ(reopened.getKnownTileCount(), 4u);
+    EXPECT_EQ(reopened.getResidentTileCount(), 0u);
+    size_t count = 0;
+    reopened.forEachNPC({0, 0, 99, 199}, [&](const NPCStore&, size_t) { ++count; });
+    EXPECT_EQ(count, 20u);
+    EXPECT_EQ(reopened.getLoadCount(), 2u);
+    EXPECT_LE(reopened.getResidentBytes(), budget);
+    std::filesystem::remove_all("test_tiles_lru");
+}
+
+TEST(TiledWorldTest, LargeWorldFightsAcrossTileBorder) {
+    TiledWorldConfig config;
+    config.directory = "test_tiles_large";
+    std::filesystem::remove_all(config.directory);
+    config.tilesX = 1000;
+    config.tilesY = 1000;
+    TiledWorld world(config);
+    // Граница плиток x = 250000; редактор такие координаты отвергает
+    ASSERT_TRUE(world.addNPC(NPCType::Dragon, "Smaug", 249999.5, 400000));
+    ASSERT_TRUE(world.addNPC(NPCType::Bull, "Ferdinand", 250000.5, 400000));
+    ASSERT_TRUE(world.addNPC(NPCType::Bull, "Far", 250020, 400000));
+    EXPECT_EQ(world.getKnownTileCount(), 2u);
+
+    BattleVisitor visitor;
+    auto log = std::make_shared<RecordingObserver>();
+    visitor.addObserver(log);
+    EXPECT_FALSE(world.startBattle(config.tileSize + 1, visitor));
+    ASSERT_TRUE(world.startBattle(5, visitor));
+    EXPECT_EQ(log->events, std::vector<std::string>{"Smaug>Ferdinand"});
+    std::filesystem::remove_all(config.directory);
+}
+
+// Тесты для пространственных запросов
+static std::set<size_t> bruteRadius(const Editor& editor, double x, double y, double r, const NPCFilter& filter) {
+    std::set<size_t> result;
+    const NPCStore& store = editor.getStore();
+    for (size_t i = 0; i < store.size(); ++i) {
+        double dx = store.x(i) - x, dy = store.y(i) - y;
+        if (dx * dx + dy * dy <= r * r && filter.accepts(store, i)) {
+            result.insert(i);
+        }
+    }
+    return result;
+}
+
+TEST(QueryTest, RadiusAndRectFollowWorldChanges) {
+    Editor editor;
+    std::mt19937 rng(21);
+    for (size_t i = 0; i < 3000; ++i) {
+        editor.addNPC(makeRandomNPC(rng, i));
+    }
+    std::uniform_real_distribution<double> coord(-20, 520);
+    const NPCFilter filters[] = {NPCFilter(), NPCFilter::alive(), NPCFilter::ofType(NPCType::Bull, true)};
+    auto check = [&] {
+        for (size_t q = 0; q < 50; ++q) {
+            double x = coord(rng), y = coord(rng), r = coord(rng) / 10;
+            for (const NPCFilter& filter : filters) {
+                std::set<size_t> found;
+                editor.queryRadius(x, y, r, [&](size_t i) { EXPECT_TRUE(found.insert(i).second); }, filter);
+                EXPECT_EQ(found, bruteRadius(editor, x, y, r, filter));
+
+                const MapBounds area{x, y, x + r * 3, y + r};
+                std::set<size_t> expected;
+                for (size_t i = 0; i < editor.getNPCCount(); ++i) {
+                    const NPCStore& store = editor.getStore();
+                    if (store.x(i) >= area.minX && store.x(i) <= area.maxX && store.y(i) >= area.minY &&
+                        store.y(i) <= area.maxY && filter.accepts(store, i)) {
+                        expected.insert(i);
+                    }
+                }
+                std::vector<size_t> out(expected.size() + 1);
+                size_t count = editor.queryRect(area, out.data(), out.size(), filter);
+                EXPECT_EQ(std::set<size_t>(out.begin(), out.begin() + count), expected);
+            }
+        }
+    };
+    check();
+    // Индекс обновляется при бое, удалении, добавлении и движении
+    BattleVisitor visitor;
+    editor.startBattle(10, visitor);
+    check();
+    editor.removeDeadNPCs();
+    for (size_t i = 0; i < 500; ++i) {
+        editor.addNPC(makeRandomNPC(rng, 10000 + i));
+    }
+    check();
+    SimulationConfig config;
+    config.speed = 300;
+    Simulation simulation(editor, config);
+    simulation.run(3, visitor);
+    check();
+    editor.clear();
+    editor.addNPC(std::make_shared<Frog>("Alone", 10, 10));
+    check();
+}
+
+TEST(QueryTest, NearestKIsSortedByDistance) {
+    Editor editor;
+    std::mt19937 rng(4);
+    for (size_t i = 0; i < 2000; ++i) {
+        editor.addNPC(makeRandomNPC(rng, i));
+    }
+    std::uniform_real_distribution<double> coord(-50, 550);
+    for (size_t q = 0; q < 100; ++q) {
+        double x = coord(rng), y = coord(rng);
+        size_t k = q % 7 == 0 ? 3000 : 1 + q % 20;
+        NPCFilter filter = q % 2 ? NPCFilter::ofType(NPCType::Frog) : NPCFilter();
+        const NPCStore& store = editor.getStore();
+        std::vector<std::pair<double, size_t>> all;
+        for (size_t i = 0; i < store.size(); ++i) {
+            if (filter.accepts(store, i)) {
+                double dx = store.x(i) - x, dy = store.y(i) - y;
+                all.emplace_back(dx * dx + dy * dy, i);
+            }
+        }
+        std::sort(all.begin(), all.end());
+        all.resize(std::min(all.size(), k));
+
+        std::vector<size_t> out(k);
+        size_t count = editor.nearestK(x, y, k, out.data(), filter);
+        ASSERT_EQ(count, all.size());
+        for (size_t n = 0; n < count; ++n) {
+            EXPECT_EQ(out[n], all[n].second) << q << " " << n;
+        }
+    }
+}
+
+TEST(QueryTest, OutputBufferIsNotOverrun) {
+    Editor editor;
+    for (size_t i = 0; i < 10; ++i) {
+        editor.addNPC(std::make_shared<Dragon>("D" + std::to_string(i), 100 + i, 100));
+    }
+    size_t out[4] = {};
+    size_t guard = 12345;
+    EXPECT_EQ(editor.queryRadius(105, 100, 10, out, 3), 10u);
+    EXPECT_EQ(out[3], 0u);
+    EXPECT_EQ(editor.queryRadius(105, 100, -1, out, 3), 0u);
+    EXPECT_EQ(editor.nearestK(0, 0, 0, &guard), 0u);
+    EXPECT_EQ(guard, 12345u);
+    EXPECT_EQ(editor.nearestK(0, 0, 1, out), 1u);
+    EXPECT_EQ(out[0], 0u);
+}
+
+TEST(QueryTest, ConcurrentFirstQueriesShareOneIndex) {
+    Editor editor;
+    std::mt19937 rng(12);
+    for (size_t i = 0; i < 5000; ++i) {
+        editor.addNPC(makeRandomNPC(rng, i));
+    }
+    // Индекс ещё не построен: все потоки запрашивают его одновременно
+    std::vector<size_t> counts(8, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < counts.size(); ++t) {
+        threads.emplace_back([&, t] {
+            editor.queryRect({0, 0, Editor::MAP_SIZE, Editor::MAP_SIZE}, [&](size_t) { ++counts[t]; });
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t count : counts) {
+        EXPECT_EQ(count, 5000u);
+    }
+}
+
+// Тесты для массового добавления
+TEST(BulkAddTest, MatchesOneByOneAdds) {
+    Editor bulk, single;
+    bulk.addNPC(std::make_shared<Frog>("Existing", 1, 1));
+    single.addNPC(std::make_shared<Frog>("Existing", 1, 1));
+
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<double> coord(-50, 550);
+    std::uniform_int_distribution<int> nameNumber(0, 300);
+    std::vector<std::string> names;
+    for (size_t k = 0; k < 1000; ++k) {
+        // Повторы имён внутри пакета и с уже существующим NPC
+        names.push_back(k % 97 == 0 ? "Existing" : "N" + std::to_string(nameNumber(rng)));
+    }
+    names.push_back("Bad");
+    std::vector<NPCSpec> specs;
+    for (size_t k = 0; k < names.size(); ++k) {
+        specs.push_back({static_cast<NPCType>(k % 3), names[k], coord(rng), coord(rng)});
+    }
+    specs.back().x = std::nan("");
+
+    BulkAddResult result = bulk.addNPCs(specs);
+    size_t added = 0;
+    for (size_t k = 0; k < specs.size(); ++k) {
+        const NPCSpec& spec = specs[k];
+        bool expected = single.addNPC(NPCFactory::createNPC(spec.type, spec.name, spec.x, spec.y));
+        EXPECT_EQ(result.isAdded(k), expected) << k;
+        added += expected ? 1 : 0;
+    }
+    EXPECT_FALSE(result.isAdded(specs.size() - 1));
+    EXPECT_EQ(result.addedCount, added);
+    EXPECT_GT(added, 100u);
+    EXPECT_LT(added, 900u);
+    EXPECT_EQ(worldLines(bulk), worldLines(single));
+}
+
+TEST(BulkAddTest, SmallBatchesGrowGeometrically) {
+    Editor editor;
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 20000; ++i) {
+        names.push_back("N" + std::to_string(i));
+    }
+    size_t growths = 0;
+    size_t capacity = editor.getStore().capacity();
+    for (size_t batch = 0; batch < 2000; ++batch) {
+        std::vector<NPCSpec> specs;
+        for (size_t k = 0; k < 10; ++k) {
+            specs.push_back({NPCType::Frog, names[batch * 10 + k], 1, 1});
+        }
+        ASSERT_EQ(editor.addNPCs(specs).addedCount, 10u);
+        if (editor.getStore().capacity() != capacity) {
+            capacity = editor.getStore().capacity();
+            ++growths;
+        }
+    }
+    EXPECT_EQ(editor.getNPCCount(), 20000u);
+    // Удвоение: около log2(20000 / 10) перевыделений, а не одно на пакет
+    EXPECT_LE(growths, 16u);
+}
+
+TEST(BulkAddTest, BatchIsJournaled) {
+    removeJournal("test_bulk");
+    std::vector<NPCSpec> specs = {{NPCType::Dragon, "A", 1, 1}, {NPCType::Bull, "B", 2, 2},
+                                  {NPCType::Frog, "A", 3, 3}};
+    {
+        Editor editor;
+        ASSERT_TRUE(editor.openJournal("test_bulk"));
+        BulkAddResult result = editor.addNPCs(specs);
+        EXPECT_EQ(result.addedCount, 2u);
+        EXPECT_EQ(result.added[0], 0b011u);
+    }
+    Editor reopened;
+    ASSERT_TRUE(reopened.openJournal("test_bulk"));
+    EXPECT_EQ(reopened.getNPCCount(), 2u);
+    EXPECT_FALSE(reopened.isNameUnique("B"));
+    reopened.closeJournal();
+    removeJournal("test_bulk");
+}
+
+// Тесты для одновременного боя
+TEST(SimultaneousBattleTest, KilledNPCStillFightsThisRound) {
+    Editor editor;
+    editor.setBattleMode(BattleMode::Simultaneous);
+    editor.addNPC(std::make_shared<Dragon>("A", 10, 10));
+    editor.addNPC(std::make_shared<Dragon>("B", 11, 10));
+    editor.addNPC(std::make_shared<Bull>("C", 12, 10));
+    BattleVisitor visitor;
+    auto log = std::make_shared<RecordingObserver>();
+    visitor.addObserver(log);
+    editor.startBattle(5, visitor);
+    // В последовательном бою A и B гибнут в первой паре, и C выживает
+    EXPECT_EQ(log->events, (std::vector<std::string>{"A и B>друг друга", "A>C", "B>C"}));
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_FALSE(editor.getStore().isAlive(i));
+    }
+}
+
+TEST(SimultaneousBattleTest, StatsSkipPairsWithDeadNPCs) {
+    // Повторный бой: B погиб в первом, и пара (A, B) не считается ни в одном режиме
+    for (BattleMode mode : {BattleMode::Sequential, BattleMode::Simultaneous}) {
+        Editor editor;
+        editor.setBattleMode(mode);
+        editor.addNPC(std::make_shared<Dragon>("A", 10, 10));
+        editor.addNPC(std::make_shared<Bull>("B", 11, 10));
+        BattleVisitor visitor;
+        BattleStats first;
+        editor.startBattle(5, visitor, &first);
+        EXPECT_EQ(first.candidatePairs, 1u);
+        EXPECT_EQ(first.fights, 1u);
+
+        BattleStats second;
+        editor.startBattle(5, visitor, &second);
+        EXPECT_EQ(second.candidatePairs, 0u);
+        EXPECT_EQ(second.fights, 0u);
+    }
+}
+
+TEST(SimultaneousBattleTest, MatchesFrozenPairScanForAnyThreadCount) {
+    std::mt19937 rng(13);
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (size_t i = 0; i < 3000; ++i) {
+        npcs.push_back(makeRandomNPC(rng, i));
+    }
+    const double range = 9;
+
+    // Эталон: полный перебор пар по флагам жизни до боя
+    std::vector<uint8_t> expectedAlive(npcs.size(), 1);
+    std::vector<std::string> expectedEvents;
+    for (size_t i = 0; i < npcs.size(); ++i) {
+        for (size_t j = i + 1; j < npcs.size(); ++j) {
+            BattleOutcome outcome = battleOutcome(npcs[i]->getTypeTag(), npcs[j]->getTypeTag());
+            if (outcome == BattleOutcome::None || npcs[i]->distanceTo(*npcs[j]) > range) {
+                continue;
+            }
+            expectedAlive[j] = 0;
+            if (outcome == BattleOutcome::MutualKill) {
+                expectedAlive[i] = 0;
+                expectedEvents.push_back(std::string(npcs[i]->getName()) + " и " + std::string(npcs[j]->getName()) +
+                                         ">друг друга");
+            } else {
+                expectedEvents.push_back(std::string(npcs[i]->getName()) + ">" + std::string(npcs[j]->getName()));
+            }
+        }
+    }
+
+    for (size_t threads : {1, 4}) {
+        Editor editor;
+        editor.setBattleMode(BattleMode::Simultaneous);
+        editor.setThreadCount(threads);
+        for (const auto& npc : npcs) {
+            editor.addNPC(NPCFactory::createNPC(npc->getTypeTag(), npc->getName(), npc->getX(), npc->getY()));
+        }
+        BattleVisitor visitor;
+        auto log = std::make_shared<RecordingObserver>();
+        visitor.addObserver(log);
+        BattleStats stats;
+        editor.startBattle(range, visitor, &stats);
+        EXPECT_EQ(log->events, expectedEvents) << threads;
+        EXPECT_EQ(stats.fights, expectedEvents.size());
+        // Все живые к началу боя пары сражаются
+        EXPECT_EQ(stats.candidatePairs, stats.fights);
+        for (size_t i = 0; i < npcs.size(); ++i) {
+            EXPECT_EQ(editor.getStore().isAlive(i), expectedAlive[i] != 0) << threads << " " << i;
+        }
+
+        // Без наблюдателей — те же убитые
+        Editor silent;
+        silent.setBattleMode(BattleMode::Simultaneous);
+        silent.setThreadCount(threads);
+        for (const auto& npc : npcs) {
+            silent.addNPC(NPCFactory::createNPC(npc->getTypeTag(), npc->getName(), npc->getX(), npc->getY()));
+        }
+        BattleVisitor quiet;
+        silent.startBattle(range, quiet);
+        EXPECT_EQ(worldLines(silent), worldLines(editor));
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();